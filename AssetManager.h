@@ -2,40 +2,210 @@
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Audio/SoundBuffer.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include "FileWatcher.h"
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <fstream>
 #include <iostream>
 
+//Approximate memory an asset takes, for the budgets
+inline std::size_t GetAssetBytes(const sf::Texture& texture, const std::string&) {
+	return (std::size_t)texture.getSize().x * texture.getSize().y * 4;
+}
+
+//The sample count already covers every channel
+inline std::size_t GetAssetBytes(const sf::SoundBuffer& soundBuffer, const std::string&) {
+	return (std::size_t)soundBuffer.getSampleCount() * sizeof(sf::Int16);
+}
+
+//Fonts don't report their size; the face is read from the file, so the file size is close
+inline std::size_t GetAssetBytes(const sf::Font&, const std::string& filepath) {
+	std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+	return file.is_open() ? (std::size_t)file.tellg() : 0;
+}
+
+struct AssetStats {
+	std::size_t assetCount = 0, residentCount = 0;
+	std::size_t bytes = 0, budget = 0;
+	uint64_t hits = 0, reloads = 0, evictions = 0;
+};
+
+//Assets by name. Assets handed out through Acquire may be evicted, least recently used
+//first, once nothing holds them and the manager is over its budget; the next Acquire loads
+//them again. GetAsset returns a plain reference, so an asset fetched that way is pinned.
 template<typename Asset>
 class AssetManager {
 private:
-	std::unordered_map<std::string, Asset*> assets;
-public:
-	AssetManager() {}
+	struct Record {
+		std::shared_ptr<Asset> asset;  //Null while evicted
+		std::string filepath;
+		std::size_t bytes = 0;
+		uint64_t lastUse = 0;
+		bool isPinned = false;
+	};
 
-	bool LoadAsset(const std::string& assetName, const std::string& filepath) {
-		Asset* asset = new Asset();
-		if (!asset->loadFromFile(filepath)) {
+	std::unordered_map<std::string, Record> records;
+	mutable std::mutex mutex;
+
+	std::size_t budget;  //Bytes, 0 for no limit
+	uint64_t useClock;
+	AssetStats stats;
+
+	bool Load(const std::string& assetName, Record& record) {
+		auto asset = std::make_shared<Asset>();
+		if (!asset->loadFromFile(record.filepath)) {
 			std::cout << "Couldn't load the asset " << assetName << std::endl;
-			delete asset;
 			return false;
 		}
 
-		assets.insert(std::make_pair(assetName, asset));
+		record.asset = std::move(asset);
+		record.bytes = GetAssetBytes(*record.asset, record.filepath);
+		stats.bytes += record.bytes;
+		stats.residentCount++;
 		return true;
 	}
 
-	const Asset& GetAsset(const std::string& assetName) {
-		return *assets[assetName];
+	Record* Touch(const std::string& assetName) {
+		auto it = records.find(assetName);
+		if (it == records.end()) return nullptr;
+
+		Record& record = it->second;
+		if (record.asset) {
+			stats.hits++;
+		}
+		else {
+			if (!Load(assetName, record)) return nullptr;
+			stats.reloads++;
+		}
+
+		record.lastUse = ++useClock;
+		return &record;
+	}
+
+	//Evicts unreferenced assets, oldest use first, until the budget is met
+	void Trim(const Record* keep) {
+		while (budget > 0 && stats.bytes > budget) {
+			Record* oldest = nullptr;
+			for (auto& [assetName, record] : records) {
+				if (&record == keep || record.isPinned || !record.asset || record.asset.use_count() > 1) continue;
+				if (!oldest || record.lastUse < oldest->lastUse) oldest = &record;
+			}
+			if (!oldest) return;
+
+			stats.bytes -= oldest->bytes;
+			stats.residentCount--;
+			stats.evictions++;
+			oldest->asset.reset();
+		}
+	}
+public:
+	AssetManager() {
+		budget = 0;
+		useClock = 0;
 	}
 
-	~AssetManager() {
-		int value = 0;
-		for (auto it = assets.begin(); it != assets.end();) {
-			it = assets.erase(it);
-			value++;
-			if (value >= (int)assets.size()) break;
-			it++;
+	//Loading a name again copies the new file into the asset already handed out, so
+	//references from GetAsset and pointers from Acquire stay valid and see the new data
+	bool LoadAsset(const std::string& assetName, const std::string& filepath) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Record record;
+		record.filepath = filepath;
+		if (!Load(assetName, record)) return false;
+		record.lastUse = ++useClock;
+
+		auto it = records.find(assetName);
+		if (it != records.end()) {
+			Record& existing = it->second;
+			if (existing.asset) {
+				stats.bytes -= existing.bytes;
+				stats.residentCount--;
+
+				*existing.asset = *record.asset;
+				record.asset = std::move(existing.asset);
+			}
+			record.isPinned = existing.isPinned;
+			existing = std::move(record);
 		}
+		else {
+			it = records.emplace(assetName, std::move(record)).first;
+			stats.assetCount++;
+		}
+
+		Trim(&it->second);
+		return true;
+	}
+
+	bool HasAsset(const std::string& assetName) const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return records.find(assetName) != records.end();
+	}
+
+	//Shared reference that keeps the asset loaded while held; null if it isn't known or fails to load
+	std::shared_ptr<const Asset> Acquire(const std::string& assetName) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Record* record = Touch(assetName);
+		if (!record) return nullptr;
+
+		std::shared_ptr<const Asset> asset = record->asset;
+		Trim(record);
+		return asset;
+	}
+
+	//Reference valid for the manager's lifetime; the asset is never evicted afterwards.
+	//An unknown asset gives an empty one instead of a dangling reference.
+	const Asset& GetAsset(const std::string& assetName) {
+		static const Asset missing;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Record* record = Touch(assetName);
+		if (!record) return missing;
+
+		record->isPinned = true;
+		return *record->asset;
+	}
+
+	//Changes a loaded asset in place, so references to it stay valid, and recounts its size.
+	//An evicted asset is left alone, it picks up its file when it is loaded again.
+	template<typename Function>
+	bool ModifyAsset(const std::string& assetName, Function fn) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = records.find(assetName);
+		if (it == records.end() || !it->second.asset) return false;
+
+		Record& record = it->second;
+		fn(*record.asset);
+
+		stats.bytes -= record.bytes;
+		record.bytes = GetAssetBytes(*record.asset, record.filepath);
+		stats.bytes += record.bytes;
+		Trim(&record);
+		return true;
+	}
+
+	//Calls fn(assetName, filepath) for every asset, loaded or evicted
+	template<typename Function>
+	void ForEachFile(Function fn) const {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& [assetName, record] : records) fn(assetName, record.filepath);
+	}
+
+	void SetBudget(std::size_t bytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		budget = bytes;
+		Trim(nullptr);
+	}
+
+	AssetStats GetStats() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		AssetStats current = stats;
+		current.budget = budget;
+		return current;
 	}
 };
 
@@ -65,7 +235,73 @@ public:
 		return fontManager.LoadAsset(fontName, filepath);
 	}
 
+	bool HasTexture(const std::string& textureName) const { return textureManager.HasAsset(textureName); }
+	bool HasSoundBuffer(const std::string& soundBufferName) const { return soundManager.HasAsset(soundBufferName); }
+	bool HasFont(const std::string& fontName) const { return fontManager.HasAsset(fontName); }
+
+	//Reloads the assets loaded so far whenever their files change. Files are decoded on the
+	//watcher's thread; the commit swaps the result into the existing object, so references
+	//handed out earlier stay valid. Textures are decoded to an image and only uploaded in the
+	//commit, so the render channel must be committed on the thread that draws.
+	void WatchAssets(FileWatcher& watcher, uint32_t renderChannel = 0, uint32_t audioChannel = 0) {
+		textureManager.ForEachFile([&](const std::string& name, const std::string& filepath) {
+			watcher.Watch(filepath, [this, name](const std::string& path) -> FileWatcher::Commit {
+				auto image = std::make_shared<sf::Image>();
+				if (!image->loadFromFile(path)) return nullptr;
+				return [this, name, image]() {
+					textureManager.ModifyAsset(name, [&](sf::Texture& texture) { texture.loadFromImage(*image); });
+				};
+			}, renderChannel);
+		});
+
+		soundManager.ForEachFile([&](const std::string& name, const std::string& filepath) {
+			watcher.Watch(filepath, [this, name](const std::string& path) -> FileWatcher::Commit {
+				auto buffer = std::make_shared<sf::SoundBuffer>();
+				if (!buffer->loadFromFile(path)) return nullptr;
+				return [this, name, buffer]() {
+					soundManager.ModifyAsset(name, [&](sf::SoundBuffer& soundBuffer) { soundBuffer = *buffer; });
+				};
+			}, audioChannel);
+		});
+
+		fontManager.ForEachFile([&](const std::string& name, const std::string& filepath) {
+			watcher.Watch(filepath, [this, name](const std::string& path) -> FileWatcher::Commit {
+				auto staged = std::make_shared<sf::Font>();
+				if (!staged->loadFromFile(path)) return nullptr;
+				return [this, name, staged]() {
+					fontManager.ModifyAsset(name, [&](sf::Font& font) { font = *staged; });
+				};
+			}, renderChannel);
+		});
+	}
+
 	const sf::Texture& GetTexture(const std::string& textureName) { return textureManager.GetAsset(textureName); }
 	const sf::SoundBuffer& GetSoundBuffer(const std::string& soundBufferName) { return soundManager.GetAsset(soundBufferName); }
 	const sf::Font& GetFont(const std::string& fontName) { return fontManager.GetAsset(fontName); }
+
+	std::shared_ptr<const sf::Texture> AcquireTexture(const std::string& textureName) { return textureManager.Acquire(textureName); }
+	std::shared_ptr<const sf::SoundBuffer> AcquireSoundBuffer(const std::string& soundBufferName) { return soundManager.Acquire(soundBufferName); }
+	std::shared_ptr<const sf::Font> AcquireFont(const std::string& fontName) { return fontManager.Acquire(fontName); }
+
+	//Budgets in bytes, 0 for no limit
+	void SetTextureBudget(std::size_t bytes) { textureManager.SetBudget(bytes); }
+	void SetSoundBufferBudget(std::size_t bytes) { soundManager.SetBudget(bytes); }
+	void SetFontBudget(std::size_t bytes) { fontManager.SetBudget(bytes); }
+
+	AssetStats GetTextureStats() const { return textureManager.GetStats(); }
+	AssetStats GetSoundBufferStats() const { return soundManager.GetStats(); }
+	AssetStats GetFontStats() const { return fontManager.GetStats(); }
+
+	void PrintStats(std::ostream& out) const {
+		const char* names[] = { "Textures", "Sound buffers", "Fonts" };
+		AssetStats all[] = { GetTextureStats(), GetSoundBufferStats(), GetFontStats() };
+
+		for (int i = 0; i < 3; i++) {
+			const AssetStats& stats = all[i];
+			out << names[i] << ": " << stats.residentCount << "/" << stats.assetCount << " loaded, "
+				<< stats.bytes / 1024 << " KiB";
+			if (stats.budget > 0) out << " of " << stats.budget / 1024 << " KiB";
+			out << ", " << stats.hits << " hits, " << stats.reloads << " reloads, " << stats.evictions << " evictions\n";
+		}
+	}
 };
\ No newline at end of file
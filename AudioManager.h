@@ -0,0 +1,142 @@
+#pragma once
+#include <SFML/Audio/Sound.hpp>
+#include <SFML/Audio/Music.hpp>
+#include "AssetManager.h"
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+enum class SoundPriority : uint8_t {
+	Low,     //Dropped or stolen first, for sounds that repeat constantly
+	Normal,
+	High     //Never stolen by a lower priority sound
+};
+
+//Plays short sounds on a fixed pool of voices, so no sf::Sound is created per event and the
+//number of playing sounds never exceeds the pool size. Long tracks are streamed with sf::Music.
+class AudioManager {
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Voice {
+		sf::Sound sound;
+		SoundPriority priority = SoundPriority::Low;
+		Clock::time_point startTime;
+	};
+
+	struct Cue {
+		const sf::SoundBuffer* buffer;
+		SoundPriority priority;
+		Clock::duration minInterval;  //Plays closer together than this are dropped
+		Clock::time_point lastPlayed;
+	};
+
+	std::vector<Voice> voices;
+	std::unordered_map<std::string, Cue> cues;
+	sf::Music music;
+	float volume;
+
+	AudioManager() {
+		//Sounds are stopped before the buffers they point to go away
+		AssetHolder::Get();
+
+		voices.resize(16);
+		volume = 100.0f;
+	}
+
+	//Free voice, else the oldest voice playing something of lower or equal priority, else nullptr
+	Voice* FindVoice(SoundPriority priority) {
+		Voice* stolen = nullptr;
+
+		for (auto& voice : voices) {
+			if (voice.sound.getStatus() != sf::Sound::Playing) return &voice;
+
+			if (voice.priority <= priority) {
+				bool isBetter = !stolen || voice.priority < stolen->priority ||
+					(voice.priority == stolen->priority && voice.startTime < stolen->startTime);
+				if (isBetter) stolen = &voice;
+			}
+		}
+
+		return stolen;
+	}
+public:
+	static AudioManager& Get() {
+		static AudioManager audio;
+		return audio;
+	}
+
+	~AudioManager() {
+		for (auto& voice : voices) voice.sound.stop();
+		music.stop();
+	}
+
+	//Changes the number of voices; sounds that are playing are cut off
+	void SetVoiceCount(std::size_t count) {
+		for (auto& voice : voices) voice.sound.stop();
+		voices.clear();
+		voices.resize(count);
+	}
+
+	//Names a loaded sound buffer as a cue; returns false if the buffer isn't loaded
+	bool AddCue(const std::string& cueName, const std::string& soundBufferName, SoundPriority priority = SoundPriority::Normal, float minIntervalSeconds = 0.0f) {
+		AssetHolder& assets = AssetHolder::Get();
+		if (!assets.HasSoundBuffer(soundBufferName)) return false;
+
+		Cue cue;
+		cue.buffer = &assets.GetSoundBuffer(soundBufferName);
+		cue.priority = priority;
+		cue.minInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(minIntervalSeconds));
+		cue.lastPlayed = Clock::time_point();
+		cues[cueName] = cue;
+		return true;
+	}
+
+	//Plays a cue if it exists, isn't rate limited and a voice can be had; returns whether it played
+	bool Play(const std::string& cueName, float pitch = 1.0f, float cueVolume = 100.0f) {
+		auto it = cues.find(cueName);
+		if (it == cues.end()) return false;
+
+		Cue& cue = it->second;
+		Clock::time_point now = Clock::now();
+		if (cue.lastPlayed != Clock::time_point() && now - cue.lastPlayed < cue.minInterval) return false;
+
+		Voice* voice = FindVoice(cue.priority);
+		if (!voice) return false;
+
+		voice->sound.stop();
+		voice->sound.setBuffer(*cue.buffer);
+		voice->sound.setPitch(pitch);
+		voice->sound.setVolume(cueVolume * volume / 100.0f);
+		voice->sound.play();
+		voice->priority = cue.priority;
+		voice->startTime = now;
+
+		cue.lastPlayed = now;
+		return true;
+	}
+
+	//Streams a track from disk, only a small buffer of it is decoded at a time
+	bool PlayMusic(const std::string& filepath, bool isLooping = true) {
+		if (!music.openFromFile(filepath)) return false;
+
+		music.setLoop(isLooping);
+		music.setVolume(volume);
+		music.play();
+		return true;
+	}
+
+	void StopMusic() { music.stop(); }
+
+	void SetVolume(float masterVolume) {
+		volume = masterVolume;
+		music.setVolume(volume);
+	}
+
+	std::size_t GetPlayingCount() const {
+		std::size_t count = 0;
+		for (auto& voice : voices) count += voice.sound.getStatus() == sf::Sound::Playing;
+		return count;
+	}
+};
@@ -0,0 +1,170 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+//Watches files for changes and reloads them in two steps: a stage function loads the file
+//on the watcher's thread and returns a commit, which the owner of the data runs later on its
+//own thread through CommitReloads. Only Linux (inotify) is supported, elsewhere nothing fires.
+class FileWatcher {
+public:
+	typedef std::function<void()> Commit;
+	typedef std::function<Commit(const std::string& filepath)> Stage;
+private:
+	struct Entry {
+		std::string filepath;
+		Stage stage;
+		uint32_t channel;
+	};
+
+	//Directory -> file name -> what to do when it changes. Directories are watched instead of
+	//the files themselves, since editors usually save by replacing the file.
+	std::unordered_map<std::string, std::unordered_map<std::string, std::vector<Entry>>> entries;
+	std::unordered_map<int, std::string> directories;
+	std::mutex entryMutex;
+
+	std::vector<std::vector<Commit>> commits;
+	std::mutex commitMutex;
+
+	std::thread thread;
+	std::atomic<bool> isRunning;
+	int fd;
+
+	static void SplitPath(const std::string& filepath, std::string& directory, std::string& name) {
+		std::size_t slash = filepath.find_last_of('/');
+		directory = slash == std::string::npos ? "." : filepath.substr(0, slash);
+		name = slash == std::string::npos ? filepath : filepath.substr(slash + 1);
+	}
+
+	void Reload(const std::string& directory, const std::string& name) {
+		std::vector<Entry> changed;
+		{
+			std::lock_guard<std::mutex> lock(entryMutex);
+			auto dir = entries.find(directory);
+			if (dir == entries.end()) return;
+			auto file = dir->second.find(name);
+			if (file == dir->second.end()) return;
+			changed = file->second;
+		}
+
+		for (auto& entry : changed) {
+			Commit commit = entry.stage(entry.filepath);
+			if (!commit) continue;
+
+			std::lock_guard<std::mutex> lock(commitMutex);
+			if (commits.size() <= entry.channel) commits.resize(entry.channel + 1);
+			commits[entry.channel].push_back(std::move(commit));
+		}
+	}
+
+#ifdef __linux__
+	void WatchLoop() {
+		//Saves come as bursts of events, files are reloaded once the burst has been quiet for this long
+		const int settleMilliseconds = 50;
+
+		alignas(inotify_event) char buffer[4096];
+		std::vector<std::pair<std::string, std::string>> changed;
+
+		while (isRunning) {
+			pollfd request = { fd, POLLIN, 0 };
+			int ready = poll(&request, 1, changed.empty() ? 100 : settleMilliseconds);
+
+			if (ready <= 0) {
+				for (auto& [directory, name] : changed) Reload(directory, name);
+				changed.clear();
+				continue;
+			}
+
+			ssize_t length = read(fd, buffer, sizeof(buffer));
+			for (ssize_t offset = 0; offset < length;) {
+				const inotify_event* event = (const inotify_event*)(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				if (event->len == 0) continue;
+
+				std::string directory;
+				{
+					std::lock_guard<std::mutex> lock(entryMutex);
+					auto dir = directories.find(event->wd);
+					if (dir == directories.end()) continue;
+					directory = dir->second;
+				}
+
+				std::pair<std::string, std::string> file(directory, event->name);
+				if (std::find(changed.begin(), changed.end(), file) == changed.end()) changed.push_back(file);
+			}
+		}
+	}
+#endif
+public:
+	FileWatcher() {
+		isRunning = false;
+		fd = -1;
+
+#ifdef __linux__
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd >= 0) {
+			isRunning = true;
+			thread = std::thread(&FileWatcher::WatchLoop, this);
+		}
+#endif
+	}
+
+	~FileWatcher() {
+		isRunning = false;
+		if (thread.joinable()) thread.join();
+
+#ifdef __linux__
+		if (fd >= 0) close(fd);
+#endif
+	}
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	inline bool IsSupported() const { return fd >= 0; }
+
+	//Calls stage on the watcher's thread whenever the file is written; a non-empty commit it
+	//returns is queued on the channel
+	bool Watch(const std::string& filepath, Stage stage, uint32_t channel = 0) {
+		if (fd < 0) return false;
+
+		std::string directory, name;
+		SplitPath(filepath, directory, name);
+
+		std::lock_guard<std::mutex> lock(entryMutex);
+		if (entries.find(directory) == entries.end()) {
+#ifdef __linux__
+			int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+			if (wd < 0) return false;
+			directories[wd] = directory;
+#endif
+		}
+
+		entries[directory][name].push_back({ filepath, std::move(stage), channel });
+		return true;
+	}
+
+	//Runs the commits staged for the channel, on the calling thread
+	void CommitReloads(uint32_t channel = 0) {
+		std::vector<Commit> ready;
+		{
+			std::lock_guard<std::mutex> lock(commitMutex);
+			if (channel >= commits.size() || commits[channel].empty()) return;
+			ready.swap(commits[channel]);
+		}
+
+		for (auto& commit : ready) commit();
+	}
+};
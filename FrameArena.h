@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+//Every operator new in the program, counted by the replacements in main.cpp
+inline std::atomic<uint64_t> heapAllocationCount{ 0 };
+
+//Scratch memory for one frame of drawing. Allocating bumps an offset and nothing is freed
+//on its own, Reset at the start of the next frame releases it all at once. A frame that
+//needs more than the block holds spills into extra blocks, and the next Reset swaps them for
+//one block big enough, so frames like the last one never touch the heap.
+//Only for the thread that draws, and only for types that need no destructor.
+class FrameArena {
+private:
+	std::unique_ptr<unsigned char[]> block;
+	std::size_t capacity, used;
+
+	std::vector<std::unique_ptr<unsigned char[]>> overflow;
+	std::size_t overflowBytes;
+
+	uint64_t frame, frameStartAllocations;
+	std::atomic<uint64_t> lastFrameAllocations;
+	std::atomic<std::size_t> lastFrameBytes;
+
+	FrameArena() {
+		capacity = 64 * 1024;
+		block.reset(new unsigned char[capacity]);
+		used = overflowBytes = 0;
+
+		frame = 0;
+		frameStartAllocations = heapAllocationCount.load(std::memory_order_relaxed);
+		lastFrameAllocations = 0;
+		lastFrameBytes = 0;
+	}
+public:
+	static FrameArena& Get() {
+		static FrameArena arena;
+		return arena;
+	}
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	//Alignment up to that of std::max_align_t
+	void* Allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+		std::size_t start = (used + alignment - 1) & ~(alignment - 1);
+		if (start + size <= capacity) {
+			used = start + size;
+			return block.get() + start;
+		}
+
+		overflow.emplace_back(new unsigned char[size]);
+		overflowBytes += size;
+		return overflow.back().get();
+	}
+
+	//Default constructed items, valid until the next Reset
+	template<typename T>
+	T* AllocateArray(std::size_t count) {
+		static_assert(std::is_trivially_destructible_v<T>, "The arena never runs destructors");
+
+		T* items = (T*)Allocate(count * sizeof(T), alignof(T));
+		for (std::size_t i = 0; i < count; i++) new (items + i) T();
+		return items;
+	}
+
+	//Starts a new frame, keeping the figures of the one that ended
+	void Reset() {
+		lastFrameAllocations = heapAllocationCount.load(std::memory_order_relaxed) - frameStartAllocations;
+		lastFrameBytes = used + overflowBytes;
+
+		if (!overflow.empty()) {
+			capacity = (used + overflowBytes) * 2;
+			block.reset(new unsigned char[capacity]);
+			overflow.clear();
+		}
+
+		used = overflowBytes = 0;
+		frame++;
+		frameStartAllocations = heapAllocationCount.load(std::memory_order_relaxed);
+	}
+
+	inline uint64_t GetFrame() const { return frame; }
+
+	//Heap allocations made by every thread during the last frame
+	inline uint64_t GetLastFrameAllocations() const { return lastFrameAllocations; }
+
+	void PrintStats(std::ostream& out) const {
+		out << "Frame: " << lastFrameAllocations << " heap allocations, " << lastFrameBytes << " bytes of scratch" << std::endl;
+	}
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+//Text with a cursor, stored with an unused gap at the cursor. Typing and deleting next to
+//the cursor only move the ends of the gap; moving the cursor copies the characters it passes.
+class GapBuffer {
+private:
+	std::vector<char> buffer;
+	std::size_t gapStart, gapEnd;
+
+	void Grow() {
+		std::size_t oldSize = buffer.size();
+		std::size_t tail = oldSize - gapEnd;
+		buffer.resize(std::max<std::size_t>(oldSize * 2, 16));
+
+		std::memmove(buffer.data() + buffer.size() - tail, buffer.data() + gapEnd, tail);
+		gapEnd = buffer.size() - tail;
+	}
+public:
+	GapBuffer()
+		: gapStart(0), gapEnd(0) {}
+
+	void Insert(char c) {
+		if (gapStart == gapEnd) Grow();
+		buffer[gapStart++] = c;
+	}
+
+	//Removes the character before the cursor, like backspace
+	bool EraseBefore() {
+		if (gapStart == 0) return false;
+		gapStart--;
+		return true;
+	}
+
+	//Removes the character after the cursor, like delete
+	bool EraseAfter() {
+		if (gapEnd == buffer.size()) return false;
+		gapEnd++;
+		return true;
+	}
+
+	void SetCursor(std::size_t position) {
+		position = std::min(position, GetSize());
+
+		if (position < gapStart) {
+			std::size_t count = gapStart - position;
+			std::memmove(buffer.data() + gapEnd - count, buffer.data() + position, count);
+			gapStart -= count;
+			gapEnd -= count;
+		}
+		else if (position > gapStart) {
+			std::size_t count = position - gapStart;
+			std::memmove(buffer.data() + gapStart, buffer.data() + gapEnd, count);
+			gapStart += count;
+			gapEnd += count;
+		}
+	}
+
+	void Clear() {
+		gapStart = 0;
+		gapEnd = buffer.size();
+	}
+
+	inline std::size_t GetCursor() const { return gapStart; }
+	inline std::size_t GetSize() const { return buffer.size() - (gapEnd - gapStart); }
+
+	//Writes the text into out, reusing its capacity
+	void CopyTo(std::string& out) const {
+		out.assign(buffer.data(), gapStart);
+		out.append(buffer.data() + gapEnd, buffer.size() - gapEnd);
+	}
+
+	std::string GetString() const {
+		std::string out;
+		CopyTo(out);
+		return out;
+	}
+};
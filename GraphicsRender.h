@@ -6,9 +6,16 @@
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include <list>
+#include <vector>
+#include <string>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include "SaveState.h"
+#include "FrameArena.h"
 
 struct Tile {
 	int x, y;
@@ -18,10 +25,47 @@ struct Tile {
 		: x(x), y(y), tileCharacter(c) {}
 };
 
+//Rectangle of tiles, [left, right) x [top, bottom)
+struct LevelRegion {
+	uint32_t left, top, right, bottom;
+
+	LevelRegion()
+		: left(UINT32_MAX), top(UINT32_MAX), right(0), bottom(0) {}
+	LevelRegion(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom)
+		: left(left), top(top), right(right), bottom(bottom) {}
+
+	bool IsEmpty() const { return left >= right || top >= bottom; }
+
+	void Expand(uint32_t x, uint32_t y) {
+		left = std::min(left, x);
+		top = std::min(top, y);
+		right = std::max(right, x + 1);
+		bottom = std::max(bottom, y + 1);
+	}
+
+	void Merge(const LevelRegion& other) {
+		if (other.IsEmpty()) return;
+		left = std::min(left, other.left);
+		top = std::min(top, other.top);
+		right = std::max(right, other.right);
+		bottom = std::max(bottom, other.bottom);
+	}
+
+	inline uint32_t GetWidth() const { return IsEmpty() ? 0 : right - left; }
+	inline uint32_t GetHeight() const { return IsEmpty() ? 0 : bottom - top; }
+};
+
 class Level {
 private:
 	std::vector<std::string> levelVector;
 	uint32_t width, height;
+
+	//Tiles changed since the last TakeDirtyRegion
+	LevelRegion dirtyRegion;
+
+	void MarkAllDirty() {
+		dirtyRegion = LevelRegion(0, 0, width, height);
+	}
 public:
 	Level() {
 		width = height = 0;
@@ -43,6 +87,7 @@ public:
 			}
 			levelVector.push_back(line);
 		}
+		MarkAllDirty();
 	}
 
 	void ClearLevel() {
@@ -51,7 +96,10 @@ public:
 
 	void SetCharacter(uint32_t x, uint32_t y, char c) {
 		if (x < 0 || y < 0 || x >(width - 1) || y >(height - 1)) return;
+		if (levelVector[y][x] == c) return;
+
 		levelVector[y][x] = c;
+		dirtyRegion.Expand(x, y);
 	}
 
 	inline char GetCharacter(uint32_t x, uint32_t y) const {
@@ -59,6 +107,100 @@ public:
 		return levelVector[y][x];
 	}
 
+	//Writes c over [x1, x2) of row y in one step
+	void SetSpan(uint32_t y, uint32_t x1, uint32_t x2, char c) {
+		x2 = std::min(x2, width);
+		if (y >= height || x1 >= x2) return;
+
+		std::fill(levelVector[y].begin() + x1, levelVector[y].begin() + x2, c);
+		dirtyRegion.Merge(LevelRegion(x1, y, x2, y + 1));
+	}
+
+	//Fills the part of the rectangle [x1, x2) x [y1, y2) inside the level
+	void FillRect(int x1, int y1, int x2, int y2, char c) {
+		uint32_t left = (uint32_t)std::max(x1, 0), top = (uint32_t)std::max(y1, 0);
+		uint32_t right = (uint32_t)std::max(std::min(x2, (int)width), 0);
+		uint32_t bottom = (uint32_t)std::max(std::min(y2, (int)height), 0);
+
+		for (uint32_t i = top; i < bottom; i++) {
+			SetSpan(i, left, right, c);
+		}
+	}
+
+	//Scanline fill of the 4-connected area of equal tiles around (x, y); returns the tiles changed
+	uint32_t FloodFill(uint32_t x, uint32_t y, char c) {
+		if (x >= width || y >= height) return 0;
+
+		char target = levelVector[y][x];
+		if (target == c) return 0;
+
+		uint32_t count = 0;
+		std::vector<std::pair<uint32_t, uint32_t>> seeds = { { x, y } };
+
+		while (!seeds.empty()) {
+			auto [seedX, seedY] = seeds.back();
+			seeds.pop_back();
+
+			const std::string& row = levelVector[seedY];
+			if (row[seedX] != target) continue;
+
+			uint32_t left = seedX, right = seedX + 1;
+			while (left > 0 && row[left - 1] == target) left--;
+			while (right < width && row[right] == target) right++;
+
+			SetSpan(seedY, left, right, c);
+			count += right - left;
+
+			//One seed per run of target tiles touching the span from above and below
+			for (uint32_t nextY : { seedY - 1, seedY + 1 }) {
+				if (nextY >= height) continue;
+
+				const std::string& next = levelVector[nextY];
+				for (uint32_t i = left; i < right; i++) {
+					if (next[i] == target && (i == left || next[i - 1] != target)) seeds.push_back({ i, nextY });
+				}
+			}
+		}
+
+		return count;
+	}
+
+	//Bresenham line of square brushes brushSize tiles wide. Consecutive points on one row are
+	//written as a single span.
+	void LineBrush(int x1, int y1, int x2, int y2, char c, int brushSize = 1) {
+		int dx = std::abs(x2 - x1), dy = -std::abs(y2 - y1);
+		int stepX = x1 < x2 ? 1 : -1, stepY = y1 < y2 ? 1 : -1;
+		int error = dx + dy;
+		int before = (brushSize - 1) / 2, after = brushSize / 2 + 1;
+
+		int runStart = x1, runEnd = x1, runY = y1;
+		auto flush = [&]() {
+			FillRect(std::min(runStart, runEnd) - before, runY - before, std::max(runStart, runEnd) + after, runY + after, c);
+		};
+
+		int x = x1, y = y1;
+		while (x != x2 || y != y2) {
+			int doubled = 2 * error;
+			if (doubled >= dy) {
+				error += dy;
+				x += stepX;
+			}
+			if (doubled <= dx) {
+				error += dx;
+				y += stepY;
+			}
+
+			if (y != runY) {
+				flush();
+				runStart = x;
+				runY = y;
+			}
+			runEnd = x;
+		}
+
+		flush();
+	}
+
 	void InitializeLevelString(uint32_t w, uint32_t h) {
 		width = w;
 		height = h;
@@ -70,25 +212,31 @@ public:
 			}
 			levelVector.push_back(line);
 		}
+		MarkAllDirty();
 	}
 
-	static Level LoadLevel(const std::string& filepath) {
+	//Rows of a level file; false if the file can't be read or its rows differ in length
+	static bool ReadLevelRows(const std::string& filepath, std::vector<std::string>& rows) {
 		std::ifstream reader(filepath);
+		if (!reader.is_open()) return false;
 
-		Level level;
+		rows.clear();
+		std::string line;
+		while (reader >> line) {
+			if (!rows.empty() && line.size() != rows[0].size()) return false;
+			rows.push_back(line);
+		}
 
-		if (reader.is_open()) {
-			while (!reader.eof()) {
-				std::string line;
-				reader >> line;
-				level.levelVector.push_back(line);
-			}
+		return !rows.empty();
+	}
 
-			reader.close();
-		}
+	static Level LoadLevel(const std::string& filepath) {
+		Level level;
 
-		level.width = level.levelVector[0].size();
-		level.height = level.levelVector.size();
+		std::vector<std::string> rows;
+		if (ReadLevelRows(filepath, rows)) {
+			level.SetLevel(rows);
+		}
 
 		return level;
 	}
@@ -97,6 +245,63 @@ public:
 		levelVector = level;
 		width = level[0].size();
 		height = level.size();
+		MarkAllDirty();
+	}
+
+	//Same as SetLevel, but when the size is unchanged only the differing part of each row is
+	//written, so the dirty region covers just what changed
+	void UpdateLevel(const std::vector<std::string>& level) {
+		if (level.size() != height || level.empty() || level[0].size() != width) {
+			SetLevel(level);
+			return;
+		}
+
+		for (uint32_t i = 0; i < height; i++) {
+			UpdateRow(i, level[i]);
+		}
+	}
+
+	//Writes the part of row y between the first and the last tile that differ from row
+	void UpdateRow(uint32_t y, const std::string& row) {
+		if (y >= height || row.size() != width || row == levelVector[y]) return;
+
+		uint32_t first = 0, last = width;
+		while (row[first] == levelVector[y][first]) first++;
+		while (row[last - 1] == levelVector[y][last - 1]) last--;
+
+		PasteRegion(LevelRegion(first, y, last, y + 1), row.substr(first, last - first));
+	}
+
+	void SaveState(StateWriter& out) const {
+		out.Write(width);
+		out.Write(height);
+		for (uint32_t i = 0; i < height; i++) {
+			out.WriteBytes(levelVector[i].data(), width);
+		}
+	}
+
+	//Like UpdateLevel, only the tiles that differ from the saved ones are written
+	bool LoadState(StateReader& in) {
+		uint32_t w = 0, h = 0;
+		if (!in.Read(w) || !in.Read(h)) return false;
+		if (w == 0 || h == 0 || (uint64_t)w * h > in.GetRemaining()) return false;
+
+		if (w != width || h != height) {
+			std::vector<std::string> rows(h, std::string(w, '.'));
+			for (auto& row : rows) {
+				if (!in.ReadBytes(&row[0], w)) return false;
+			}
+			SetLevel(rows);
+			return true;
+		}
+
+		std::string row(w, '.');
+		for (uint32_t i = 0; i < h; i++) {
+			if (!in.ReadBytes(&row[0], w)) return false;
+			UpdateRow(i, row);
+		}
+
+		return true;
 	}
 
 	void SaveLevel(const std::string& filename) {
@@ -130,60 +335,123 @@ public:
 		}
 	}
 
+	//Calls fn(y, x1, x2, c) for every run of equal tiles other than '.' inside the region, row by row
+	template<typename Function>
+	void ForEachSpan(const LevelRegion& region, Function fn) const {
+		uint32_t right = std::min(region.right, width), bottom = std::min(region.bottom, height);
+
+		for (uint32_t y = region.top; y < bottom; y++) {
+			const std::string& row = levelVector[y];
+			for (uint32_t x = region.left; x < right;) {
+				uint32_t start = x;
+				char c = row[x];
+				while (x < right && row[x] == c) x++;
+
+				if (c != '.') fn(y, start, x, c);
+			}
+		}
+	}
+
+	inline const LevelRegion& PeekDirtyRegion() const { return dirtyRegion; }
+
+	LevelRegion TakeDirtyRegion() {
+		LevelRegion region = dirtyRegion;
+		dirtyRegion = LevelRegion();
+		return region;
+	}
+
+	//Tiles of the region, row after row
+	void CopyRegion(const LevelRegion& region, std::string& tiles) const {
+		tiles.clear();
+		for (uint32_t i = region.top; i < region.bottom; i++) {
+			tiles.append(levelVector[i], region.left, region.GetWidth());
+		}
+	}
+
+	void PasteRegion(const LevelRegion& region, const std::string& tiles) {
+		uint32_t w = region.GetWidth();
+		for (uint32_t i = region.top; i < region.bottom; i++) {
+			levelVector[i].replace(region.left, w, tiles, (i - region.top) * w, w);
+		}
+		dirtyRegion.Merge(region);
+	}
+
 	inline uint32_t GetWidth() const { return width; }
 	inline uint32_t GetHeight() const { return height; }
 
 	std::vector<std::string> GetLevel() const { return levelVector; }
 };
 
-void DrawLine(sf::RenderWindow& window, float x1, float y1, float x2, float y2, sf::Color color = sf::Color::White) {
-	sf::VertexArray line(sf::LineStrip, 2);
+//The helpers below draw from vertices on the stack or in the FrameArena, so they don't
+//allocate; call them from the thread that draws.
 
-	line[0].position = { x1, y1 };
-	line[0].color = color;
-	line[1].position = { x2, y2 };
-	line[1].color = color;
+void DrawLine(sf::RenderWindow& window, float x1, float y1, float x2, float y2, sf::Color color = sf::Color::White) {
+	sf::Vertex line[2] = { sf::Vertex({ x1, y1 }, color), sf::Vertex({ x2, y2 }, color) };
+	window.draw(line, 2, sf::Lines);
+}
 
-	window.draw(line);
+//2x2 pixel square as the four corners of a quad
+inline void SetPointQuad(sf::Vertex* quad, float x, float y, sf::Color color) {
+	quad[0] = sf::Vertex({ x, y }, color);
+	quad[1] = sf::Vertex({ x + 2.0f, y }, color);
+	quad[2] = sf::Vertex({ x + 2.0f, y + 2.0f }, color);
+	quad[3] = sf::Vertex({ x, y + 2.0f }, color);
 }
 
 void DrawPoint(sf::RenderWindow& window, float x, float y, sf::Color color = sf::Color::White) {
-	sf::RectangleShape pixel({ 2.0f, 2.0f });
-	pixel.setPosition({ x, y });
-	pixel.setFillColor(color);
-
-	window.draw(pixel);
+	sf::Vertex quad[4];
+	SetPointQuad(quad, x, y, color);
+	window.draw(quad, 4, sf::Quads);
 }
 
 void DrawPolygon(sf::RenderWindow& window, const std::vector<sf::Vector2f>& points, sf::Color color = sf::Color::White) {
-	for (std::size_t i = 1; i <= points.size(); i++) {
-		auto [x1, y1] = i == points.size() ? points[0] : points[i - 1];
-		auto [x2, y2] = i == points.size() ? points[points.size() - 1] : points[i];
+	std::size_t n = points.size();
+	if (n == 0) return;
 
-		DrawLine(window, x1, y1, x2, y2, color);
+	sf::Vertex* lines = FrameArena::Get().AllocateArray<sf::Vertex>(n * 2);
+	for (std::size_t i = 0; i < n; i++) {
+		lines[i * 2] = sf::Vertex(points[i], color);
+		lines[i * 2 + 1] = sf::Vertex(points[(i + 1) % n], color);
 	}
+
+	window.draw(lines, n * 2, sf::Lines);
 }
 
 void DrawGrid(sf::RenderWindow& window, float size, sf::Color color = sf::Color::White) {
 	auto [sizeX, sizeY] = window.getSize();
-
-	for (uint32_t i = 0; i < sizeY / (uint32_t)size; i++) {
-		DrawLine(window, 0.0f, i * size, (float)sizeX, i * size, color);
+	uint32_t rows = sizeY / (uint32_t)size, columns = sizeX / (uint32_t)size;
+	if (rows + columns == 0) return;
+
+	sf::Vertex* lines = FrameArena::Get().AllocateArray<sf::Vertex>((rows + columns) * 2);
+	sf::Vertex* out = lines;
+	for (uint32_t i = 0; i < rows; i++) {
+		*out++ = sf::Vertex({ 0.0f, i * size }, color);
+		*out++ = sf::Vertex({ (float)sizeX, i * size }, color);
 	}
 
-	for (uint32_t i = 0; i < sizeX / (uint32_t)size; i++) {
-		DrawLine(window, i * size, 0.0f, i * size, (float)sizeY, color);
+	for (uint32_t i = 0; i < columns; i++) {
+		*out++ = sf::Vertex({ i * size, 0.0f }, color);
+		*out++ = sf::Vertex({ i * size, (float)sizeY }, color);
 	}
+
+	window.draw(lines, (rows + columns) * 2, sf::Lines);
 }
 
-void DrawCircle(sf::RenderWindow& window, const sf::Vector2f& origin, float radius, sf::Color color = sf::Color::White) {
+void DrawEllipse(sf::RenderWindow& window, const sf::Vector2f& origin, float width, float height, sf::Color color = sf::Color::White) {
+	const int nPoints = 360;
 	auto [h, k] = origin;
-	for (float i = 1; i < 361; i++) {
-		float x = h + radius * cosf(i);
-		float y = k + radius * sinf(i);
 
-		DrawPoint(window, x, y, color);
+	sf::Vertex* quads = FrameArena::Get().AllocateArray<sf::Vertex>(nPoints * 4);
+	for (int i = 0; i < nPoints; i++) {
+		float angle = (float)(i + 1);
+		SetPointQuad(quads + i * 4, h + width * cosf(angle), k + height * sinf(angle), color);
 	}
+
+	window.draw(quads, nPoints * 4, sf::Quads);
+}
+
+void DrawCircle(sf::RenderWindow& window, const sf::Vector2f& origin, float radius, sf::Color color = sf::Color::White) {
+	DrawEllipse(window, origin, radius, radius, color);
 }
 
 sf::Vector2f WrapCoords(const sf::Vector2u& windowSize, sf::Vector2f pos, float offset) {
@@ -193,55 +461,159 @@ sf::Vector2f WrapCoords(const sf::Vector2u& windowSize, sf::Vector2f pos, float
 	if (pos.x < offset) outputPos.x = pos.x + (float)windowSize.x;
 	else if (pos.x > (float)windowSize.x - offset) outputPos.x = pos.x - (float)windowSize.x;
 	if (pos.y < offset) outputPos.y = pos.y + (float)windowSize.y;
-	else if (pos.x > (float)windowSize.x - offset) outputPos.x = pos.y - (float)windowSize.y;
+	else if (pos.y > (float)windowSize.y - offset) outputPos.y = pos.y - (float)windowSize.y;
 
 	return outputPos;
 }
 
-void DrawWireFrameModel(sf::RenderWindow& window, const std::vector<sf::Vector2f>& modelCoords, float x, float y, float angle = 0.0f, float scale = 1.0f, sf::Color color = sf::Color::White, float offset = 0.0f) {
-	std::vector<sf::Vector2f> transformedCoords;
-	std::size_t nVertices = modelCoords.size();
-	transformedCoords.resize(nVertices);
+struct WireFrameInstance {
+	float x, y, angle, scale;
+	sf::Color color;
+};
 
-	//Rotation
-	for (int i = 0; i < (int)nVertices; i++) {
-		transformedCoords[i].x = modelCoords[i].x * cosf(angle) - modelCoords[i].y * sinf(angle);
-		transformedCoords[i].y = modelCoords[i].x * sinf(angle) + modelCoords[i].y * cosf(angle);
+//Draws many copies of one wireframe model as a single sf::Lines draw call. The instances'
+//rotation-scale and translation are kept as separate arrays, and one fused
+//rotate-scale-translate-wrap pass computes every point of every instance. Its inner loop
+//runs over the instances, so it is long and contiguous and vectorizes even for models of
+//a few points. All buffers are reused between frames.
+class WireFrameBatch {
+private:
+	std::vector<float> modelX, modelY;
+	std::vector<float> cosScale, sinScale, moveX, moveY;  //Per instance
+	std::vector<float> outX, outY;                        //Point i of instance k at i * count + k
+	std::vector<sf::Vertex> vertices;
+
+	void Transform(std::size_t count, float width, float height, float offset) {
+		std::size_t n = modelX.size();
+		const float* a = cosScale.data(); const float* b = sinScale.data();
+		const float* tx = moveX.data(); const float* ty = moveY.data();
+
+		for (std::size_t i = 0; i < n; i++) {
+			float mx = modelX[i], my = modelY[i];
+			float* ox = outX.data() + i * count; float* oy = outY.data() + i * count;
+
+			for (std::size_t k = 0; k < count; k++) {
+				float x = mx * a[k] - my * b[k] + tx[k];
+				float y = mx * b[k] + my * a[k] + ty[k];
+
+				//Same as WrapCoords, without branches. The comparisons are combined as ints,
+				//GCC doesn't vectorize the loop when each one is converted to a float.
+				ox[k] = x + width * (float)((int)(x < offset) - (int)(x > width - offset));
+				oy[k] = y + height * (float)((int)(y < offset) - (int)(y > height - offset));
+			}
+		}
 	}
-
-	//Scaling
-	for (int i = 0; i < (int)nVertices; i++) {
-		transformedCoords[i] *= scale;
+public:
+	void SetModel(const std::vector<sf::Vector2f>& modelCoords) {
+		std::size_t n = modelCoords.size();
+		modelX.resize(n);
+		modelY.resize(n);
+
+		for (std::size_t i = 0; i < n; i++) {
+			modelX[i] = modelCoords[i].x;
+			modelY[i] = modelCoords[i].y;
+		}
 	}
 
-	//Translation
-	for (int i = 0; i < (int)nVertices; i++) {
-		transformedCoords[i] += sf::Vector2f(x, y);
+	//Closed outline of the model for every instance, wrapped around the window edges
+	void Draw(sf::RenderWindow& window, const WireFrameInstance* instances, std::size_t count, float offset = 0.0f) {
+		std::size_t n = modelX.size();
+		if (n < 2 || count == 0) return;
+
+		cosScale.resize(count);
+		sinScale.resize(count);
+		moveX.resize(count);
+		moveY.resize(count);
+		for (std::size_t k = 0; k < count; k++) {
+			cosScale[k] = cosf(instances[k].angle) * instances[k].scale;
+			sinScale[k] = sinf(instances[k].angle) * instances[k].scale;
+			moveX[k] = instances[k].x;
+			moveY[k] = instances[k].y;
+		}
+
+		auto [sizeX, sizeY] = window.getSize();
+		outX.resize(count * n);
+		outY.resize(count * n);
+		Transform(count, (float)sizeX, (float)sizeY, offset);
+
+		vertices.resize(count * n * 2);
+		sf::Vertex* out = vertices.data();
+		for (std::size_t k = 0; k < count; k++) {
+			sf::Color color = instances[k].color;
+			for (std::size_t i = 0; i < n; i++) {
+				std::size_t j = i + 1 < n ? i + 1 : 0;
+				out[0].position = { outX[i * count + k], outY[i * count + k] };
+				out[0].color = color;
+				out[1].position = { outX[j * count + k], outY[j * count + k] };
+				out[1].color = color;
+				out += 2;
+			}
+		}
+
+		window.draw(vertices.data(), vertices.size(), sf::Lines);
 	}
+};
 
-	//Render
-	for (int i = 0; i < (int)nVertices + 1; i++) {
-		int j = i + 1;
+void DrawWireFrameModel(sf::RenderWindow& window, const std::vector<sf::Vector2f>& modelCoords, float x, float y, float angle = 0.0f, float scale = 1.0f, sf::Color color = sf::Color::White, float offset = 0.0f) {
+	static WireFrameBatch batch;
 
-		auto [x1, y1] = WrapCoords(window.getSize(), transformedCoords[i % nVertices], offset);
-		auto [x2, y2] = WrapCoords(window.getSize(), transformedCoords[j % nVertices], offset);
+	batch.SetModel(modelCoords);
+	WireFrameInstance instance = { x, y, angle, scale, color };
+	batch.Draw(window, &instance, 1, offset);
+}
 
-		DrawLine(window, x1, y1, x2, y2, color);
+//sf::Text objects kept from frame to frame. The nth text drawn in a frame gets the nth slot,
+//so a frame that shows the same strings as the last one lays out and allocates nothing.
+class TextSlots {
+private:
+	struct Slot {
+		sf::Text text;
+		std::string str;
+		const sf::Font* font = nullptr;
+	};
+
+	std::vector<Slot> slots;
+	std::size_t next;
+	uint64_t frame;
+
+	TextSlots() {
+		next = 0;
+		frame = 0;
+	}
+public:
+	static TextSlots& Get() {
+		static TextSlots textSlots;
+		return textSlots;
 	}
-}
 
-void DrawEllipse(sf::RenderWindow& window, const sf::Vector2f& origin, float width, float height, sf::Color color = sf::Color::White) {
-	auto [h, k] = origin;
-	for (float i = 1; i < 361; i++) {
-		float x = h + width * cosf(i);
-		float y = k + height * sinf(i);
+	//Valid until the next Acquire
+	sf::Text& Acquire(const sf::Font& font, const char* str, std::size_t length, uint32_t characterSize) {
+		uint64_t currentFrame = FrameArena::Get().GetFrame();
+		if (currentFrame != frame) {
+			frame = currentFrame;
+			next = 0;
+		}
+
+		if (next == slots.size()) slots.emplace_back();
+		Slot& slot = slots[next++];
+
+		if (slot.font != &font) {
+			slot.text.setFont(font);
+			slot.font = &font;
+		}
+		if (slot.text.getCharacterSize() != characterSize) slot.text.setCharacterSize(characterSize);
+
+		if (slot.str.size() != length || slot.str.compare(0, length, str, length) != 0) {
+			slot.str.assign(str, length);
+			slot.text.setString(slot.str);
+		}
 
-		DrawPoint(window, x, y, color);
+		return slot.text;
 	}
-}
+};
 
 void RenderText(sf::RenderWindow& window, const sf::Font& font, float x, float y, const std::string& str, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
-	sf::Text text(str, font, characterSize);
+	sf::Text& text = TextSlots::Get().Acquire(font, str.data(), str.size(), characterSize);
 	text.setPosition({ x, y });
 	text.setFillColor(color);
 
@@ -249,13 +621,17 @@ void RenderText(sf::RenderWindow& window, const sf::Font& font, float x, float y
 }
 
 void DrawTextWithValue(sf::RenderWindow& window, const sf::Font& font, float x, float y, const std::string& str, int value, sf::Color color = sf::Color::White, uint32_t characterSize = 32) {
-	sf::Text text(str, font, characterSize);
+	const std::size_t maxDigits = 12;
+
+	//"str value", formatted in the arena
+	char* buffer = FrameArena::Get().AllocateArray<char>(str.size() + 1 + maxDigits);
+	std::memcpy(buffer, str.data(), str.size());
+	buffer[str.size()] = ' ';
+	char* end = std::to_chars(buffer + str.size() + 1, buffer + str.size() + 1 + maxDigits, value).ptr;
+
+	sf::Text& text = TextSlots::Get().Acquire(font, buffer, end - buffer, characterSize);
 	text.setPosition({ x, y });
 	text.setFillColor(color);
 
-	std::stringstream ss;
-	ss << str << " " << value;
-	text.setString(ss.str());
-
 	window.draw(text);
 }
\ No newline at end of file
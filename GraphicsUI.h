@@ -6,7 +6,7 @@
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Window/Event.hpp>
 #include <SFML/Graphics/Text.hpp>
-#include <sstream>
+#include "GapBuffer.h"
 #include <Windows.h>
 using namespace sf;
 
@@ -314,41 +314,47 @@ public:
 class TextBox {
 private:
 	RectangleShape box;
-	std::ostringstream textStr;
+	GapBuffer textBuffer;
+	std::string layoutStr;
 	Text text;
+	RectangleShape cursor;
 	Color color;
 
 	bool isSelected;
+	bool isTextDirty, isCursorDirty;  //The glyphs are only laid out again when the text changes
 
 	void Input(uint32_t str) {
 		if (isSelected) {
-			if (str == 0x08 || str == 0x2E) {
-				if (textStr.str().size() > 0) {
-					const std::string& initStr = textStr.str();
-					std::string newStr;
-
-					for (std::size_t i = 0; i < initStr.size() - 1; i++) {
-						newStr += initStr[i];
-					}
-
-					textStr.str("");
-					textStr << newStr;
-				}
+			if (str == 0x08) {
+				isTextDirty = textBuffer.EraseBefore() || isTextDirty;
 			}
-			else if (str < 128) {
-				textStr << static_cast<char>(str);
+			else if (str >= 0x20 && str < 0x7F) {
+				textBuffer.Insert(static_cast<char>(str));
+				isTextDirty = true;
 			}
 		}
 	}
+
+	void MoveCursor(std::size_t position) {
+		textBuffer.SetCursor(position);
+		isCursorDirty = true;
+	}
 public:
-	TextBox() {}
+	TextBox() {
+		isSelected = false;
+		isTextDirty = isCursorDirty = true;
+	}
+
 	TextBox(const sf::Vector2f& position, const sf::Vector2f& textBoxSize, sf::Color textBoxColor = sf::Color::Black)
 		: color(textBoxColor) {
 		box.setSize(textBoxSize);
 		box.setPosition(position);
 		box.setFillColor(textBoxColor);
 
+		text.setPosition(position);
+
 		isSelected = false;
+		isTextDirty = isCursorDirty = true;
 	}
 
 	void Initialize(const sf::Vector2f& position, const sf::Vector2f& textBoxSize, sf::Color textBoxColor = sf::Color::Black) {
@@ -361,13 +367,37 @@ public:
 		text.setPosition(position);
 
 		isSelected = false;
+		isTextDirty = isCursorDirty = true;
 	}
 
 	void Logic(sf::Event e) {
+		bool wasSelected = isSelected;
+
 		switch (e.type) {
 		case sf::Event::TextEntered:
 			Input(e.text.unicode);
 			break;
+		case sf::Event::KeyPressed:
+			if (!isSelected) break;
+
+			switch (e.key.code) {
+			case sf::Keyboard::Left:
+				if (textBuffer.GetCursor() > 0) MoveCursor(textBuffer.GetCursor() - 1);
+				break;
+			case sf::Keyboard::Right:
+				MoveCursor(textBuffer.GetCursor() + 1);
+				break;
+			case sf::Keyboard::Home:
+				MoveCursor(0);
+				break;
+			case sf::Keyboard::End:
+				MoveCursor(textBuffer.GetSize());
+				break;
+			case sf::Keyboard::Delete:
+				isTextDirty = textBuffer.EraseAfter() || isTextDirty;
+				break;
+			}
+			break;
 		case sf::Event::MouseButtonPressed:
 			switch (e.key.code) {
 			case sf::Mouse::Left:
@@ -384,33 +414,53 @@ public:
 			switch (e.key.code) {
 			case sf::Keyboard::Return:
 				if (isSelected) isSelected = false;
-				textStr.str("");
+				textBuffer.Clear();
+				isTextDirty = true;
 				break;
 			}
 			break;
 		}
 
-		box.setFillColor(isSelected ? Color(color.r + 25, color.g + 25, color.b + 25) : color);
-		text.setString(textStr.str() + (isSelected ? "_" : ""));
+		if (isSelected != wasSelected) {
+			box.setFillColor(isSelected ? Color(color.r + 25, color.g + 25, color.b + 25) : color);
+		}
+
+		if (isTextDirty) {
+			textBuffer.CopyTo(layoutStr);
+			text.setString(layoutStr);
+			isTextDirty = false;
+			isCursorDirty = true;
+		}
+
+		if (isCursorDirty) {
+			//Underscore below the character the cursor is in front of
+			float size = (float)text.getCharacterSize();
+			cursor.setSize({ size * 0.5f, 2.0f });
+			cursor.setPosition(text.findCharacterPos(textBuffer.GetCursor()) + sf::Vector2f(0.0f, size));
+			isCursorDirty = false;
+		}
 	}
 
 	bool GetIsSelected() const { return isSelected; }
 
 	std::string GetString() const {
-		return textStr.str();
+		return textBuffer.GetString();
 	}
 
 	void SetPosition(const sf::Vector2f& pos) {
 		box.setPosition(pos);
 		text.setPosition(pos);
+		isCursorDirty = true;
 	}
 
 	void SetFont(const Font& font) {
 		text.setFont(font);
+		isCursorDirty = true;
 	}
 
 	void Render(RenderWindow& window) {
 		window.draw(box);
 		window.draw(text);
+		if (isSelected) window.draw(cursor);
 	}
 };
\ No newline at end of file
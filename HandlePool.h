@@ -0,0 +1,110 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+//Reference to an item of a HandlePool. A handle goes stale when its item is removed,
+//even if the slot it points to is later reused by another item.
+struct Handle {
+	uint32_t index, generation;
+
+	Handle()
+		: index(UINT32_MAX), generation(0) {}
+	Handle(uint32_t index, uint32_t generation)
+		: index(index), generation(generation) {}
+
+	bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+//Items are kept densely packed for iteration; handles point at slots that map to the
+//dense position. Removal moves the last item into the hole, so it is O(1).
+template<typename T>
+class HandlePool {
+private:
+	struct Slot {
+		uint32_t dense, generation;
+	};
+
+	std::vector<T> items;
+	std::vector<uint32_t> denseToSlot;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+public:
+	Handle Insert(T item) {
+		uint32_t slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			slot = (uint32_t)slots.size();
+			slots.push_back({ 0, 0 });
+		}
+
+		slots[slot].dense = (uint32_t)items.size();
+		items.push_back(std::move(item));
+		denseToSlot.push_back(slot);
+
+		return { slot, slots[slot].generation };
+	}
+
+	bool IsValid(Handle handle) const {
+		return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+	}
+
+	T* Get(Handle handle) {
+		return IsValid(handle) ? &items[slots[handle.index].dense] : nullptr;
+	}
+
+	const T* Get(Handle handle) const {
+		return IsValid(handle) ? &items[slots[handle.index].dense] : nullptr;
+	}
+
+	bool Remove(Handle handle) {
+		if (!IsValid(handle)) return false;
+
+		uint32_t dense = slots[handle.index].dense;
+		uint32_t last = (uint32_t)items.size() - 1;
+
+		items[dense] = std::move(items[last]);
+		denseToSlot[dense] = denseToSlot[last];
+		slots[denseToSlot[dense]].dense = dense;
+
+		items.pop_back();
+		denseToSlot.pop_back();
+
+		slots[handle.index].generation++;
+		freeSlots.push_back(handle.index);
+
+		return true;
+	}
+
+	//Handle of the item currently stored at a dense position
+	Handle GetHandle(std::size_t denseIndex) const {
+		uint32_t slot = denseToSlot[denseIndex];
+		return { slot, slots[slot].generation };
+	}
+
+	void Clear() {
+		for (std::size_t i = 0; i < items.size(); i++) {
+			slots[denseToSlot[i]].generation++;
+			freeSlots.push_back(denseToSlot[i]);
+		}
+
+		items.clear();
+		denseToSlot.clear();
+	}
+
+	//Dense access, for iterating every item
+	T& operator[](std::size_t denseIndex) { return items[denseIndex]; }
+	const T& operator[](std::size_t denseIndex) const { return items[denseIndex]; }
+
+	std::size_t size() const { return items.size(); }
+	bool empty() const { return items.empty(); }
+
+	typename std::vector<T>::iterator begin() { return items.begin(); }
+	typename std::vector<T>::iterator end() { return items.end(); }
+	typename std::vector<T>::const_iterator begin() const { return items.begin(); }
+	typename std::vector<T>::const_iterator end() const { return items.end(); }
+};
@@ -0,0 +1,146 @@
+#pragma once
+#include <SFML/Window/Keyboard.hpp>
+#include <SFML/Window/Mouse.hpp>
+#include <SFML/Window/Event.hpp>
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+
+enum class Action : uint8_t {
+	MoveLeft,
+	MoveRight,
+	Jump,
+	Paint,
+	Erase,
+	PlaceRope,
+	SelectRope,
+	UndoRope,
+	DeleteRope,
+	Rewind,
+	Count
+};
+
+//State of every action for one tick, captured once and then only read
+struct InputSnapshot {
+	uint32_t down = 0, pressed = 0, released = 0;
+	sf::Vector2i mousePos;
+
+	//Arrival of the earliest input event folded into this tick, epoch if there was none
+	std::chrono::steady_clock::time_point eventTime;
+
+	inline bool IsDown(Action action) const { return down & (1u << (int)action); }
+	inline bool WasPressed(Action action) const { return pressed & (1u << (int)action); }
+	inline bool WasReleased(Action action) const { return released & (1u << (int)action); }
+};
+
+//Keys and mouse buttons as far as the events have told, for a thread that is handed the
+//events but must not poll the devices or touch the window
+struct DeviceState {
+	bool keys[sf::Keyboard::KeyCount] = {};
+	bool buttons[sf::Mouse::ButtonCount] = {};
+	sf::Vector2i mousePos;
+
+	void Apply(const sf::Event& e) {
+		switch (e.type) {
+		case sf::Event::KeyPressed:
+		case sf::Event::KeyReleased:
+			if (e.key.code >= 0 && e.key.code < sf::Keyboard::KeyCount) keys[e.key.code] = e.type == sf::Event::KeyPressed;
+			break;
+		case sf::Event::MouseButtonPressed:
+		case sf::Event::MouseButtonReleased:
+			buttons[e.mouseButton.button] = e.type == sf::Event::MouseButtonPressed;
+			mousePos = { e.mouseButton.x, e.mouseButton.y };
+			break;
+		case sf::Event::MouseMoved:
+			mousePos = { e.mouseMove.x, e.mouseMove.y };
+			break;
+		case sf::Event::LostFocus:
+			//Whatever is released while the window is out of focus never arrives as an event
+			std::fill(std::begin(keys), std::end(keys), false);
+			std::fill(std::begin(buttons), std::end(buttons), false);
+			break;
+		default:
+			break;
+		}
+	}
+};
+
+//Rebindable table from keys and mouse buttons to actions
+class ActionMap {
+private:
+	struct Binding {
+		bool isMouse;
+		int code;
+	};
+
+	std::vector<Binding> bindings[(int)Action::Count];
+
+	template<typename IsBindingDown>
+	InputSnapshot CaptureWith(IsBindingDown isBindingDown, const sf::Vector2i& mousePos, const InputSnapshot& previous) const {
+		InputSnapshot snapshot;
+
+		for (int a = 0; a < (int)Action::Count; a++) {
+			bool isDown = false;
+			for (auto& binding : bindings[a]) {
+				isDown = isDown || isBindingDown(binding);
+			}
+			snapshot.down |= (uint32_t)isDown << a;
+		}
+
+		snapshot.pressed = snapshot.down & ~previous.down;
+		snapshot.released = ~snapshot.down & previous.down;
+		snapshot.mousePos = mousePos;
+
+		return snapshot;
+	}
+public:
+	ActionMap() {
+		Bind(Action::MoveLeft, sf::Keyboard::A);
+		Bind(Action::MoveRight, sf::Keyboard::D);
+		Bind(Action::Jump, sf::Keyboard::W);
+		Bind(Action::Paint, sf::Mouse::Right);
+		Bind(Action::Erase, sf::Keyboard::LShift);
+		Bind(Action::PlaceRope, sf::Mouse::Left);
+		Bind(Action::SelectRope, sf::Mouse::Middle);
+		Bind(Action::UndoRope, sf::Keyboard::Z);
+		Bind(Action::DeleteRope, sf::Keyboard::Delete);
+		Bind(Action::Rewind, sf::Keyboard::Backspace);
+	}
+
+	void Bind(Action action, sf::Keyboard::Key key) { bindings[(int)action].push_back({ false, (int)key }); }
+	void Bind(Action action, sf::Mouse::Button button) { bindings[(int)action].push_back({ true, (int)button }); }
+	void Unbind(Action action) { bindings[(int)action].clear(); }
+
+	//Polls the devices once for all actions; edges are relative to the previous snapshot
+	InputSnapshot Capture(const sf::RenderWindow& window, const InputSnapshot& previous) const {
+		return CaptureWith([](const Binding& binding) {
+			return binding.isMouse
+				? sf::Mouse::isButtonPressed((sf::Mouse::Button)binding.code)
+				: sf::Keyboard::isKeyPressed((sf::Keyboard::Key)binding.code);
+		}, sf::Mouse::getPosition(window), previous);
+	}
+
+	//Same from the state the events have left, without polling anything
+	InputSnapshot Capture(const DeviceState& devices, const InputSnapshot& previous) const {
+		return CaptureWith([&](const Binding& binding) {
+			return binding.isMouse ? devices.buttons[binding.code] : devices.keys[binding.code];
+		}, devices.mousePos, previous);
+	}
+
+	//Whether the event presses (or releases) one of the action's bindings
+	bool IsEvent(Action action, const sf::Event& e, bool isPress = true) const {
+		bool isKey = e.type == (isPress ? sf::Event::KeyPressed : sf::Event::KeyReleased);
+		bool isMouse = e.type == (isPress ? sf::Event::MouseButtonPressed : sf::Event::MouseButtonReleased);
+		if (!isKey && !isMouse) return false;
+
+		for (auto& binding : bindings[(int)action]) {
+			if (binding.isMouse && isMouse && binding.code == (int)e.mouseButton.button) return true;
+			if (!binding.isMouse && isKey && binding.code == (int)e.key.code) return true;
+		}
+
+		return false;
+	}
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <SFML/Window/Event.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+typedef std::chrono::steady_clock LatencyClock;
+
+//Event together with the moment pollEvent handed it over
+struct TimedEvent {
+	sf::Event event;
+	LatencyClock::time_point time;
+};
+
+//Whether the event is something the player did, as opposed to window housekeeping
+inline bool IsInputEvent(const sf::Event& e) {
+	switch (e.type) {
+	case sf::Event::KeyPressed:
+	case sf::Event::KeyReleased:
+	case sf::Event::TextEntered:
+	case sf::Event::MouseButtonPressed:
+	case sf::Event::MouseButtonReleased:
+	case sf::Event::MouseWheelScrolled:
+		return true;
+	}
+
+	return false;
+}
+
+//Log-scale histogram of durations, 8 buckets per power of two (about 9% resolution)
+class LatencyHistogram {
+private:
+	static constexpr int subBuckets = 8;
+	static constexpr int bucketCount = 26 * subBuckets;
+
+	uint32_t buckets[bucketCount];
+	uint64_t count;
+	int64_t maxMicroseconds;
+
+	static int BucketOf(int64_t microseconds) {
+		if (microseconds < 1) return 0;
+		int bucket = (int)(std::log2((double)microseconds) * subBuckets);
+		return bucket < bucketCount ? bucket : bucketCount - 1;
+	}
+
+	static double BucketUpperBound(int bucket) {
+		return std::exp2((double)(bucket + 1) / subBuckets);
+	}
+public:
+	LatencyHistogram() {
+		Reset();
+	}
+
+	void Reset() {
+		for (int i = 0; i < bucketCount; i++) buckets[i] = 0;
+		count = 0;
+		maxMicroseconds = 0;
+	}
+
+	void Record(LatencyClock::duration latency) {
+		int64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+		buckets[BucketOf(microseconds)]++;
+		count++;
+		if (microseconds > maxMicroseconds) maxMicroseconds = microseconds;
+	}
+
+	//Upper bound in milliseconds of the bucket holding the given fraction of samples
+	double Percentile(double fraction) const {
+		if (count == 0) return 0.0;
+
+		uint64_t target = (uint64_t)std::ceil(fraction * count);
+		uint64_t seen = 0;
+		for (int i = 0; i < bucketCount; i++) {
+			seen += buckets[i];
+			if (seen >= target) return BucketUpperBound(i) / 1000.0;
+		}
+
+		return maxMicroseconds / 1000.0;
+	}
+
+	inline uint64_t GetCount() const { return count; }
+
+	void Print(std::ostream& out) const {
+		out << "samples " << count << "  p50 " << Percentile(0.5) << "ms  p99 " << Percentile(0.99) << "ms  max " << maxMicroseconds / 1000.0 << "ms\n";
+
+		//One row per power of two that has samples
+		for (int i = 0; i < bucketCount; i += subBuckets) {
+			uint64_t rowCount = 0;
+			for (int j = i; j < i + subBuckets; j++) rowCount += buckets[j];
+			if (rowCount == 0) continue;
+
+			out << "  <" << BucketUpperBound(i + subBuckets - 1) / 1000.0 << "ms\t" << rowCount << "\t";
+			for (uint64_t k = 0; k < rowCount * 40 / count; k++) out << '#';
+			out << "\n";
+		}
+	}
+};
+
+//Follows input from pollEvent to the display of the first frame that was simulated after it
+class LatencyTracker {
+private:
+	LatencyHistogram histogram;
+	LatencyClock::time_point lastReport;
+	LatencyClock::duration reportInterval;
+	LatencyClock::time_point lastRecorded;
+public:
+	LatencyTracker() {
+		lastReport = LatencyClock::now();
+		reportInterval = std::chrono::seconds(5);
+	}
+
+	//Earliest pending input, or the epoch if none is pending. Merging the epoch changes nothing.
+	static void MergeInputTime(LatencyClock::time_point& pending, LatencyClock::time_point time) {
+		if (time == LatencyClock::time_point()) return;
+		if (pending == LatencyClock::time_point() || time < pending) pending = time;
+	}
+
+	//Called right after window.display() with the input time carried by the frame's snapshot.
+	//A snapshot shown on several frames is only counted on the first.
+	void OnFrameDisplayed(LatencyClock::time_point inputTime, const char* mode) {
+		LatencyClock::time_point now = LatencyClock::now();
+
+		if (inputTime != LatencyClock::time_point() && inputTime != lastRecorded) {
+			histogram.Record(now - inputTime);
+			lastRecorded = inputTime;
+		}
+
+		if (now - lastReport >= reportInterval) {
+			if (histogram.GetCount() > 0) {
+				std::cout << "Input to display latency (" << mode << "): ";
+				histogram.Print(std::cout);
+			}
+			histogram.Reset();
+			lastReport = now;
+		}
+	}
+};
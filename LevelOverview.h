@@ -0,0 +1,157 @@
+#pragma once
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include "GraphicsRender.h"
+#include "TileRegistry.h"
+#include <vector>
+#include <cstdint>
+
+//Whole-level view for when the tiles are too small to draw one by one. Keeps a pyramid of
+//tile colours where every level averages 2x2 texels of the one below, weighted by how much
+//of them is covered, so the alpha of a texel is the occupancy of its block. Only the
+//level that fits the zoom is uploaded, as one texture drawn with one sprite.
+class LevelOverview {
+private:
+	struct Mip {
+		uint32_t width, height;
+		std::vector<sf::Uint8> pixels;  //RGBA
+	};
+
+	std::vector<Mip> mips;
+	uint32_t width, height;
+	float tileSize;
+
+	sf::Texture texture;
+	uint32_t textureLevel;     //Mip in the texture, or none
+	LevelRegion textureDirty;  //Texels of that mip changed since it was uploaded
+
+	void Resize(uint32_t w, uint32_t h) {
+		width = w;
+		height = h;
+		mips.clear();
+
+		do {
+			mips.push_back({ w, h, std::vector<sf::Uint8>((std::size_t)w * h * 4, 0) });
+			w = (w + 1) / 2;
+			h = (h + 1) / 2;
+		} while (mips.back().width > 1 || mips.back().height > 1);
+
+		textureLevel = UINT32_MAX;
+	}
+
+	//Averages the 2x2 blocks of the region of the finer mip into the coarser one
+	static void Downsample(const Mip& fine, Mip& coarse, const LevelRegion& region) {
+		for (uint32_t i = region.top; i < region.bottom; i++) {
+			for (uint32_t j = region.left; j < region.right; j++) {
+				uint32_t r = 0, g = 0, b = 0, a = 0;
+
+				for (uint32_t y = i * 2; y < std::min(i * 2 + 2, fine.height); y++) {
+					for (uint32_t x = j * 2; x < std::min(j * 2 + 2, fine.width); x++) {
+						const sf::Uint8* texel = &fine.pixels[((std::size_t)y * fine.width + x) * 4];
+						r += texel[0] * texel[3];
+						g += texel[1] * texel[3];
+						b += texel[2] * texel[3];
+						a += texel[3];
+					}
+				}
+
+				sf::Uint8* out = &coarse.pixels[((std::size_t)i * coarse.width + j) * 4];
+				out[0] = a ? (sf::Uint8)(r / a) : 0;
+				out[1] = a ? (sf::Uint8)(g / a) : 0;
+				out[2] = a ? (sf::Uint8)(b / a) : 0;
+				out[3] = (sf::Uint8)(a / 4);
+			}
+		}
+	}
+
+	//Mip whose texels are about one screen pixel at the current zoom and fit in a texture
+	uint32_t ChooseLevel(const sf::RenderWindow& window) const {
+		float pixelsPerTile = window.getSize().x / window.getView().getSize().x * tileSize;
+		uint32_t maxSize = sf::Texture::getMaximumSize();
+
+		uint32_t level = 0;
+		while (level + 1 < mips.size() &&
+			(pixelsPerTile * (float)(1u << level) < 1.0f || mips[level].width > maxSize || mips[level].height > maxSize)) {
+			level++;
+		}
+		return level;
+	}
+public:
+	LevelOverview() {
+		width = height = 0;
+		tileSize = 32.0f;
+		textureLevel = UINT32_MAX;
+	}
+
+	void SetTileSize(float size) { tileSize = size; }
+
+	//Recomputes the texels above the changed tiles on every level of the pyramid
+	template<typename LevelType>
+	void Update(const LevelType& level, LevelRegion region) {
+		if (level.GetWidth() != width || level.GetHeight() != height) {
+			Resize(level.GetWidth(), level.GetHeight());
+			region = LevelRegion(0, 0, width, height);
+		}
+
+		region.right = std::min(region.right, width);
+		region.bottom = std::min(region.bottom, height);
+		if (region.IsEmpty()) return;
+
+		const TileRegistry& tiles = TileRegistry::Get();
+		Mip& base = mips[0];
+		for (uint32_t i = region.top; i < region.bottom; i++) {
+			for (uint32_t j = region.left; j < region.right; j++) {
+				const sf::Color& color = tiles.GetColor(level.GetCharacter(j, i));
+				sf::Uint8* texel = &base.pixels[((std::size_t)i * width + j) * 4];
+				texel[0] = color.r;
+				texel[1] = color.g;
+				texel[2] = color.b;
+				texel[3] = color.a;
+			}
+		}
+
+		for (uint32_t k = 0; k < mips.size(); k++) {
+			if (k > 0) {
+				region = LevelRegion(region.left / 2, region.top / 2, (region.right + 1) / 2, (region.bottom + 1) / 2);
+				Downsample(mips[k - 1], mips[k], region);
+			}
+			if (k == textureLevel) textureDirty.Merge(region);
+		}
+	}
+
+	//Draws the level in world coordinates under the window's current view
+	void Render(sf::RenderWindow& window) {
+		if (mips.empty() || width == 0 || height == 0) return;
+
+		uint32_t level = ChooseLevel(window);
+		const Mip& mip = mips[level];
+
+		if (level != textureLevel) {
+			if (!texture.create(mip.width, mip.height)) return;
+			texture.update(mip.pixels.data());
+			textureLevel = level;
+			textureDirty = LevelRegion();
+		}
+		else if (!textureDirty.IsEmpty()) {
+			//Whole rows are contiguous in the mip, so the band is uploaded without copying
+			uint32_t top = textureDirty.top, rows = textureDirty.GetHeight();
+			texture.update(&mip.pixels[(std::size_t)top * mip.width * 4], mip.width, rows, 0, top);
+			textureDirty = LevelRegion();
+		}
+
+		float texelSize = tileSize * (float)(1u << level);
+		sf::Sprite sprite(texture);
+		sprite.setScale(texelSize, texelSize);
+		window.draw(sprite);
+	}
+
+	//View that shows the whole level in a window of the given size, keeping its aspect
+	sf::View GetFittingView(const sf::Vector2u& windowSize) const {
+		float levelWidth = width * tileSize, levelHeight = height * tileSize;
+		float scale = std::max(levelWidth / windowSize.x, levelHeight / windowSize.y);
+		if (scale <= 0.0f) scale = 1.0f;
+
+		return sf::View({ levelWidth / 2.0f, levelHeight / 2.0f }, { windowSize.x * scale, windowSize.y * scale });
+	}
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <SFML/Graphics/Rect.hpp>
+#include "GraphicsRender.h"
+#include "TileRegistry.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+struct RayQuery {
+	sf::Vector2f origin, direction;  //The direction doesn't need to be normalized
+	float maxDistance;
+	uint8_t mask = TileSolid;        //Tiles with any of these flags stop the ray
+};
+
+struct RayHit {
+	bool isHit = false;
+	sf::Vector2i tile;
+	sf::Vector2i normal;  //Side of the tile the ray entered through, zero if it started inside
+	sf::Vector2f point;
+	float distance = 0.0f;
+};
+
+struct BoxQuery {
+	sf::FloatRect box;
+	uint8_t mask = TileSolid;
+};
+
+struct BoxResult {
+	uint8_t flags = 0;       //Union of the flags of the matching tiles
+	uint32_t tileCount = 0;
+};
+
+struct SightQuery {
+	sf::Vector2f from, to;
+	uint8_t mask = TileSolid;
+};
+
+//Read-only spatial queries on a tile map in world coordinates. Works with any level type that
+//has GetCharacter, GetWidth and GetHeight. The batch versions split the queries into chunks
+//spread over a thread pool; the level must not change while they run.
+template<typename LevelType>
+class LevelQuery {
+private:
+	const LevelType& level;
+	float tileSize;
+
+	static const std::size_t chunkSize = 256;  //Queries per pool task
+
+	template<typename Fn>
+	static void ForChunks(ThreadPool& pool, std::size_t count, Fn fn) {
+		std::size_t nChunks = (count + chunkSize - 1) / chunkSize;
+		pool.ParallelFor(nChunks, [&](std::size_t chunk) {
+			std::size_t end = std::min(count, (chunk + 1) * chunkSize);
+			for (std::size_t i = chunk * chunkSize; i < end; i++) fn(i);
+		});
+	}
+
+	inline bool IsMatch(int x, int y, uint8_t mask) const {
+		return TileRegistry::Get().GetFlags(level.GetCharacter((uint32_t)x, (uint32_t)y)) & mask;
+	}
+public:
+	LevelQuery(const LevelType& queryLevel, float levelTileSize)
+		: level(queryLevel), tileSize(levelTileSize) {}
+
+	//First matching tile along the ray, found by stepping through the grid one tile border at a time
+	RayHit Raycast(const sf::Vector2f& origin, sf::Vector2f direction, float maxDistance, uint8_t mask = TileSolid) const {
+		const float infinity = std::numeric_limits<float>::infinity();
+		RayHit hit;
+
+		float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+		if (length > 0.0f) direction /= length;
+
+		int x = (int)std::floor(origin.x / tileSize), y = (int)std::floor(origin.y / tileSize);
+		int stepX = direction.x < 0.0f ? -1 : 1, stepY = direction.y < 0.0f ? -1 : 1;
+		int w = (int)level.GetWidth(), h = (int)level.GetHeight();
+
+		//Distance along the ray between two borders on each axis, and to the next border
+		float deltaX = direction.x != 0.0f ? std::fabs(tileSize / direction.x) : infinity;
+		float deltaY = direction.y != 0.0f ? std::fabs(tileSize / direction.y) : infinity;
+		float nextX = direction.x != 0.0f ? ((stepX > 0 ? (x + 1) * tileSize - origin.x : origin.x - x * tileSize) / std::fabs(direction.x)) : infinity;
+		float nextY = direction.y != 0.0f ? ((stepY > 0 ? (y + 1) * tileSize - origin.y : origin.y - y * tileSize) / std::fabs(direction.y)) : infinity;
+
+		float distance = 0.0f;
+		sf::Vector2i normal;
+
+		while (true) {
+			if (IsMatch(x, y, mask)) {
+				hit.isHit = true;
+				hit.tile = { x, y };
+				hit.normal = normal;
+				hit.distance = distance;
+				hit.point = origin + direction * distance;
+				return hit;
+			}
+
+			//Nothing more to find once the ray is outside the level and heading away from it
+			if ((x < 0 && stepX < 0) || (x >= w && stepX > 0) || (y < 0 && stepY < 0) || (y >= h && stepY > 0)) break;
+
+			if (nextX < nextY) {
+				distance = nextX;
+				x += stepX;
+				nextX += deltaX;
+				normal = { -stepX, 0 };
+			}
+			else {
+				distance = nextY;
+				y += stepY;
+				nextY += deltaY;
+				normal = { 0, -stepY };
+			}
+
+			if (distance > maxDistance || distance == infinity) break;
+		}
+
+		return hit;
+	}
+
+	//Tiles the box overlaps, clipped to the level
+	LevelRegion GetOverlappedTiles(const sf::FloatRect& box) const {
+		int left = std::max((int)std::floor(box.left / tileSize), 0);
+		int top = std::max((int)std::floor(box.top / tileSize), 0);
+		int right = std::min((int)std::ceil((box.left + box.width) / tileSize), (int)level.GetWidth());
+		int bottom = std::min((int)std::ceil((box.top + box.height) / tileSize), (int)level.GetHeight());
+		if (right <= left || bottom <= top) return LevelRegion();
+
+		return LevelRegion((uint32_t)left, (uint32_t)top, (uint32_t)right, (uint32_t)bottom);
+	}
+
+	//Flags of the matching tiles the box overlaps. The coordinates of those tiles are appended
+	//to tiles when it isn't null.
+	BoxResult OverlapBox(const sf::FloatRect& box, uint8_t mask = TileSolid, std::vector<sf::Vector2i>* tiles = nullptr) const {
+		BoxResult result;
+		LevelRegion region = GetOverlappedTiles(box);
+
+		const TileRegistry& registry = TileRegistry::Get();
+		for (uint32_t i = region.top; i < region.bottom; i++) {
+			for (uint32_t j = region.left; j < region.right; j++) {
+				uint8_t flags = registry.GetFlags(level.GetCharacter(j, i)) & mask;
+				if (!flags) continue;
+
+				result.flags |= flags;
+				result.tileCount++;
+				if (tiles) tiles->push_back({ (int)j, (int)i });
+			}
+		}
+
+		return result;
+	}
+
+	//Solid, hazard and one-way flags of the tiles a moving body overlaps. One-way tiles only
+	//count on rows whose top is at or below oneWayAbove, so they only stop a body that comes
+	//down onto them from above.
+	uint8_t OverlapBody(const sf::FloatRect& box, float oneWayAbove) const {
+		LevelRegion region = GetOverlappedTiles(box);
+
+		const TileRegistry& registry = TileRegistry::Get();
+		uint8_t flags = 0;
+		for (uint32_t i = region.top; i < region.bottom; i++) {
+			uint8_t rowMask = TileSolid | TileHazard | (i * tileSize >= oneWayAbove ? TileOneWay : 0);
+			for (uint32_t j = region.left; j < region.right; j++) {
+				flags |= registry.GetFlags(level.GetCharacter(j, i)) & rowMask;
+			}
+		}
+
+		return flags;
+	}
+
+	bool HasLineOfSight(const sf::Vector2f& from, const sf::Vector2f& to, uint8_t mask = TileSolid) const {
+		sf::Vector2f d = to - from;
+		float distance = std::sqrt(d.x * d.x + d.y * d.y);
+
+		RayHit hit = Raycast(from, d, distance, mask);
+		return !hit.isHit || hit.distance >= distance;
+	}
+
+	void RaycastBatch(ThreadPool& pool, const RayQuery* queries, RayHit* hits, std::size_t count) const {
+		ForChunks(pool, count, [&](std::size_t i) {
+			hits[i] = Raycast(queries[i].origin, queries[i].direction, queries[i].maxDistance, queries[i].mask);
+		});
+	}
+
+	void OverlapBatch(ThreadPool& pool, const BoxQuery* queries, BoxResult* results, std::size_t count) const {
+		ForChunks(pool, count, [&](std::size_t i) {
+			results[i] = OverlapBox(queries[i].box, queries[i].mask);
+		});
+	}
+
+	//visible[i] is 1 if nothing matching lies between the two points of query i
+	void LineOfSightBatch(ThreadPool& pool, const SightQuery* queries, uint8_t* visible, std::size_t count) const {
+		ForChunks(pool, count, [&](std::size_t i) {
+			visible[i] = HasLineOfSight(queries[i].from, queries[i].to, queries[i].mask);
+		});
+	}
+
+	inline float GetTileSize() const { return tileSize; }
+};
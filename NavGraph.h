@@ -0,0 +1,484 @@
+#pragma once
+#include "GraphicsRender.h"
+#include "TileRegistry.h"
+#include "ThreadPool.h"
+#include "LevelQuery.h"
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+//Movement constants of the agents the graph plans for, the defaults are Player's
+struct NavParams {
+	float size = 32.0f;  //Of an agent and of a tile
+	float gSpeed = 2.0f, gMax = 4.0f;
+	float jumpSpeed = 25.0f, moveSpeed = 4.0f;
+	float bounceSpeed = 40.0f;  //Speed a bounce rope launches at
+	float stickyGrip = 0.0f;    //Fraction of the walking speed a sticky rope holds back
+};
+
+//How a rope carries an agent, as far as planning goes. Later kinds win where ropes overlap.
+enum class NavRopeKind : uint8_t {
+	OneWay,  //Only catches an agent falling onto it
+	Rope,    //Also catches an agent whose feet meet it on the way up
+	Sticky,  //A rope that slows walking along it
+	Bounce   //A rope that launches an agent standing on it
+};
+
+struct NavRope {
+	sf::Vector2f position;
+	float length;
+	NavRopeKind kind;
+
+	bool operator==(const NavRope& other) const {
+		return position == other.position && length == other.length && kind == other.kind;
+	}
+};
+
+enum class NavMove : uint8_t {
+	Walk,
+	Jump,
+	Fall,    //Walk off the ledge in direction, then fly
+	Bounce   //Let the rope launch you
+};
+
+//One move between standing cells. The direction is held during ticks [moveStart, moveEnd)
+//of the flight, which starts after the jump, the launch or walking off the ledge.
+struct NavEdge {
+	uint32_t target;
+	uint16_t cost;  //Ticks
+	NavMove move;
+	int8_t direction;
+	uint8_t moveStart, moveEnd;
+};
+
+//Where an agent moving like Player can get to: the cells it can stand in, linked by the
+//walks, jumps, falls and rope bounces between them. Moves are found by flying the agent the
+//way Player::Logic does. Edits only rebuild the nodes beside them and the nodes whose moves
+//pass through them, and only once a path is asked for.
+template<typename LevelType>
+class NavGraph {
+private:
+	//The rope kinds in the same order, after none
+	enum Surface : uint8_t {
+		SurfaceNone,
+		SurfaceOneWay,
+		SurfaceRope,
+		SurfaceSticky,
+		SurfaceBounce
+	};
+
+	struct Arc {
+		int8_t direction;
+		uint8_t moveStart, moveEnd;
+	};
+
+	struct CachedPath {
+		bool isFound;
+		std::vector<NavEdge> edges;
+	};
+
+	static constexpr uint8_t always = 255;  //moveEnd of a direction held until landing
+	static constexpr uint32_t maxAirTicks = 300;
+	static constexpr std::size_t maxCachedPaths = 1024;
+
+	const LevelType& level;
+	ThreadPool* pool;
+	NavParams params;
+	uint32_t width, height;
+
+	std::vector<NavRope> ropes;
+	std::vector<uint8_t> ropeSurface;  //Per cell, the kind of rope an agent standing there is on
+	std::vector<uint8_t> isStandable;
+	std::vector<std::vector<NavEdge>> edges;
+	std::vector<LevelRegion> reach;    //Per node, the cells its moves pass through
+	LevelRegion pending;               //Changed since the last Refresh
+
+	std::unordered_map<uint64_t, CachedPath> pathCache;
+
+	//A* scratch, a cell's score is only valid when its mark is the current search
+	std::vector<uint32_t> score, parent, parentEdge, marks;
+	std::vector<std::pair<uint32_t, uint32_t>> open;
+	uint32_t searchId;
+
+	inline uint32_t GetCell(int x, int y) const { return (uint32_t)y * width + (uint32_t)x; }
+	inline bool IsInside(int x, int y) const { return x >= 0 && y >= 0 && x < (int)width && y < (int)height; }
+
+	inline uint8_t GetTileFlags(int x, int y) const {
+		return TileRegistry::Get().GetFlags(level.GetCharacter((uint32_t)x, (uint32_t)y));
+	}
+
+	static bool Intersects(const LevelRegion& a, const LevelRegion& b) {
+		return !a.IsEmpty() && !b.IsEmpty() && a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+	}
+
+	LevelRegion Clamp(const LevelRegion& region) const {
+		return LevelRegion(region.left, region.top, std::min(region.right, width), std::min(region.bottom, height));
+	}
+
+	//Row an agent stands in on the rope and the columns it covers
+	LevelRegion GetRopeRegion(const NavRope& rope) const {
+		int row = (int)std::floor(rope.position.y / params.size) - 1;
+		int left = (int)std::floor(rope.position.x / params.size);
+		int right = (int)std::ceil((rope.position.x + rope.length) / params.size);
+		if (row < 0 || right <= 0) return LevelRegion();
+
+		return Clamp(LevelRegion((uint32_t)std::max(left, 0), (uint32_t)row, (uint32_t)right, (uint32_t)row + 1));
+	}
+
+	void RebuildRopeSurface() {
+		std::fill(ropeSurface.begin(), ropeSurface.end(), SurfaceNone);
+
+		for (auto& rope : ropes) {
+			LevelRegion region = GetRopeRegion(rope);
+			for (uint32_t i = region.top; i < region.bottom; i++) {
+				for (uint32_t j = region.left; j < region.right; j++) {
+					uint8_t& surface = ropeSurface[GetCell(j, i)];
+					surface = std::max<uint8_t>(surface, (uint8_t)rope.kind + 1);
+				}
+			}
+		}
+	}
+
+	void Resize() {
+		width = level.GetWidth();
+		height = level.GetHeight();
+
+		std::size_t count = (std::size_t)width * height;
+		ropeSurface.assign(count, SurfaceNone);
+		isStandable.assign(count, 0);
+		edges.assign(count, {});
+		reach.assign(count, LevelRegion());
+		score.assign(count, 0);
+		parent.assign(count, 0);
+		parentEdge.assign(count, 0);
+		marks.assign(count, 0);
+		searchId = 0;
+
+		RebuildRopeSurface();
+		pending = LevelRegion(0, 0, width, height);
+	}
+
+	bool ComputeStandable(int x, int y) const {
+		if (GetTileFlags(x, y) & (TileSolid | TileHazard)) return false;
+		return ropeSurface[GetCell(x, y)] != SurfaceNone || (GetTileFlags(x, y + 1) & (TileSolid | TileOneWay));
+	}
+
+	//Same test as Player::TileMapCollision. The tiles it reads go into area as they are read,
+	//before a collision moves the body back off them, so the move is rebuilt when any changes.
+	uint8_t GetBodyFlags(const sf::Vector2f& position, float oneWayAbove, LevelRegion& area) const {
+		LevelQuery<LevelType> query(level, params.size);
+		sf::FloatRect body(position, { params.size, params.size });
+
+		area.Merge(query.GetOverlappedTiles(body));
+		return query.OverlapBody(body, oneWayAbove);
+	}
+
+	int64_t FindStandingCell(int x, int y) const {
+		return IsInside(x, y) && isStandable[GetCell(x, y)] ? (int64_t)GetCell(x, y) : -1;
+	}
+
+	//Cell an agent that just landed on tiles stands in, preferring the column under its middle
+	int64_t FindLandingCell(const sf::Vector2f& position) const {
+		float size = params.size;
+		int y = (int)std::lround(position.y / size);
+		int columns[3] = {
+			(int)std::floor((position.x + size / 2.0f) / size),
+			(int)std::floor(position.x / size),
+			(int)std::floor((position.x + size - 1.0f) / size)
+		};
+
+		for (int x : columns) {
+			int64_t cell = FindStandingCell(x, y);
+			if (cell >= 0) return cell;
+		}
+		return -1;
+	}
+
+	//Rope cell the agent's feet touched this tick, like Player::GetFeetBounds touching the rope.
+	//Falling, every rope the feet crossed since startY counts. Rising, only the ropes that
+	//catch from below and touch the feet where they are now, the contact test isn't swept.
+	int64_t FindRopeLanding(float startY, const sf::Vector2f& position, bool isRising) const {
+		const float band = 3.0f;
+		float size = params.size;
+
+		int first = (int)std::ceil(((isRising ? position.y : startY) + size - band) / size);
+		int last = (int)std::floor((position.y + size + band) / size);
+		int left = (int)std::floor(position.x / size), right = (int)std::floor((position.x + size - 1.0f) / size);
+		uint8_t lowest = isRising ? SurfaceRope : SurfaceOneWay;
+
+		for (int row = first; row <= last; row++) {
+			for (int x = left; x <= right; x++) {
+				if (!IsInside(x, row - 1) || ropeSurface[GetCell(x, row - 1)] < lowest) continue;
+
+				int64_t cell = FindStandingCell(x, row - 1);
+				if (cell >= 0) return cell;
+			}
+		}
+		return -1;
+	}
+
+	//Flies an agent leaving cell (x, y) upwards at launchSpeed, or walking off it when zero,
+	//until it lands. Returns the cell it lands in, -1 if it dies or doesn't land in time.
+	int64_t Fly(int x, int y, float launchSpeed, const Arc& arc, uint32_t& ticks, LevelRegion& area) const {
+		const float never = 1e30f;
+		float size = params.size;
+
+		sf::Vector2f position(x * size, y * size);
+		float velocityY = launchSpeed > 0.0f ? -launchSpeed : params.gMax;
+		bool isContact = launchSpeed <= 0.0f;
+
+		for (uint32_t tick = 0; tick < maxAirTicks; tick++) {
+			sf::Vector2f start = position;
+
+			if (tick >= arc.moveStart && (arc.moveEnd == always || tick < arc.moveEnd)) position.x += arc.direction * params.moveSpeed;
+			uint8_t flagsX = GetBodyFlags(position, never, area);
+			if (flagsX & TileSolid) position.x = start.x;
+
+			if (!isContact) velocityY = std::fminf(params.gMax, velocityY + params.gSpeed);
+			isContact = false;
+
+			position.y += velocityY;
+			uint8_t flagsY = GetBodyFlags(position, velocityY > 0.0f ? start.y + size : never, area);
+			if (flagsY & (TileSolid | TileOneWay)) {
+				position.y = start.y - ((int)start.y % (int)size);
+				isContact = velocityY > 0.0f;
+			}
+
+			if ((flagsX | flagsY) & TileHazard) return -1;
+			if (position.y > height * size) return -1;
+
+			//Player snaps up to the top of the row it started the tick in, so a landing from
+			//between rows can leave it short of the floor for a few more ticks of falling
+			int64_t cell = isContact ? FindLandingCell(position) : velocityY != 0.0f ? FindRopeLanding(start.y, position, velocityY < 0.0f) : -1;
+			ticks = tick + 1;
+			if (cell >= 0) return cell;
+		}
+
+		return -1;
+	}
+
+	//Keeps the cheapest way of reaching each target
+	void AddEdge(std::vector<NavEdge>& out, const NavEdge& edge) const {
+		for (auto& existing : out) {
+			if (existing.target != edge.target) continue;
+			if (edge.cost < existing.cost) existing = edge;
+			return;
+		}
+		out.push_back(edge);
+	}
+
+	void AddFlight(std::vector<NavEdge>& out, uint32_t from, int x, int y, float launchSpeed, const Arc& arc, NavMove move, uint16_t extraTicks, LevelRegion& area) const {
+		uint32_t ticks = 0;
+		int64_t target = Fly(x, y, launchSpeed, arc, ticks, area);
+		if (target < 0 || (uint32_t)target == from) return;
+
+		uint16_t cost = (uint16_t)std::min<uint32_t>(ticks + extraTicks, UINT16_MAX);
+		AddEdge(out, { (uint32_t)target, cost, move, arc.direction, arc.moveStart, arc.moveEnd });
+	}
+
+	void BuildNode(uint32_t cell) {
+		std::vector<NavEdge>& out = edges[cell];
+		out.clear();
+		if (!isStandable[cell]) {
+			reach[cell] = LevelRegion();
+			return;
+		}
+
+		//Straight up, and each way held all along, for the first part, for the second part
+		const Arc jumpArcs[] = {
+			{ 0, 0, 0 },
+			{ -1, 0, always }, { -1, 0, 8 }, { -1, 0, 16 }, { -1, 8, always },
+			{ 1, 0, always }, { 1, 0, 8 }, { 1, 0, 16 }, { 1, 8, always }
+		};
+		const uint8_t fallLengths[] = { 0, 8, 16, always };
+
+		int x = (int)(cell % width), y = (int)(cell / width);
+		LevelRegion area = Clamp(LevelRegion((uint32_t)std::max(x - 1, 0), (uint32_t)y, (uint32_t)x + 2, (uint32_t)y + 2));
+		bool isOnTiles = GetTileFlags(x, y + 1) & (TileSolid | TileOneWay);
+
+		float walkSpeed = params.moveSpeed;
+		if (ropeSurface[cell] == SurfaceSticky && !isOnTiles) walkSpeed *= 1.0f - params.stickyGrip;
+		uint16_t walkTicks = (uint16_t)std::min(std::ceil(params.size / std::fmax(walkSpeed, 0.01f)), (float)UINT16_MAX);
+
+		if (ropeSurface[cell] == SurfaceBounce && !isOnTiles) {
+			for (auto& arc : jumpArcs) AddFlight(out, cell, x, y, params.bounceSpeed, arc, NavMove::Bounce, 0, area);
+			reach[cell] = area;
+			return;
+		}
+
+		for (int8_t direction : { -1, 1 }) {
+			int nextX = x + direction;
+			if (!IsInside(nextX, y) || (GetTileFlags(nextX, y) & (TileSolid | TileHazard))) continue;
+
+			if (isStandable[GetCell(nextX, y)]) {
+				AddEdge(out, { GetCell(nextX, y), walkTicks, NavMove::Walk, direction, 0, always });
+				continue;
+			}
+
+			for (uint8_t length : fallLengths) {
+				AddFlight(out, cell, nextX, y, 0.0f, { direction, 0, length }, NavMove::Fall, walkTicks, area);
+			}
+		}
+
+		for (auto& arc : jumpArcs) AddFlight(out, cell, x, y, params.jumpSpeed, arc, NavMove::Jump, 0, area);
+		reach[cell] = area;
+	}
+
+	//Fewest ticks any path could take, moving sideways at full speed all the way
+	inline uint32_t Heuristic(uint32_t cell, uint32_t goal) const {
+		int dx = std::abs((int)(cell % width) - (int)(goal % width));
+		return (uint32_t)(dx * params.size / params.moveSpeed);
+	}
+
+	bool Search(uint32_t start, uint32_t goal, std::vector<NavEdge>& path) {
+		if (++searchId == 0) {
+			std::fill(marks.begin(), marks.end(), 0);
+			searchId = 1;
+		}
+
+		auto isWorse = [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) { return a.first > b.first; };
+
+		open.clear();
+		marks[start] = searchId;
+		score[start] = 0;
+		open.push_back({ Heuristic(start, goal), start });
+
+		while (!open.empty()) {
+			std::pop_heap(open.begin(), open.end(), isWorse);
+			auto [estimate, cell] = open.back();
+			open.pop_back();
+
+			if (cell == goal) break;
+			if (estimate > score[cell] + Heuristic(cell, goal)) continue;  //Reached more cheaply since it was queued
+
+			const std::vector<NavEdge>& out = edges[cell];
+			for (uint32_t i = 0; i < out.size(); i++) {
+				uint32_t target = out[i].target;
+				uint32_t targetScore = score[cell] + out[i].cost;
+				if (marks[target] == searchId && targetScore >= score[target]) continue;
+
+				marks[target] = searchId;
+				score[target] = targetScore;
+				parent[target] = cell;
+				parentEdge[target] = i;
+
+				open.push_back({ targetScore + Heuristic(target, goal), target });
+				std::push_heap(open.begin(), open.end(), isWorse);
+			}
+		}
+
+		path.clear();
+		if (marks[goal] != searchId) return false;
+
+		for (uint32_t cell = goal; cell != start; cell = parent[cell]) {
+			path.push_back(edges[parent[cell]][parentEdge[cell]]);
+		}
+		std::reverse(path.begin(), path.end());
+		return true;
+	}
+public:
+	//Rebuilds on the pool when one is given
+	NavGraph(const LevelType& navLevel, ThreadPool* threadPool = nullptr)
+		: level(navLevel), pool(threadPool), width(0), height(0), searchId(0) {}
+
+	NavGraph(const NavGraph&) = delete;
+	NavGraph& operator=(const NavGraph&) = delete;
+
+	void SetParams(const NavParams& navParams) {
+		params = navParams;
+		RebuildRopeSurface();
+		pending = LevelRegion(0, 0, width, height);
+	}
+
+	//Tiles in the region have changed
+	void Invalidate(const LevelRegion& region) {
+		pending.Merge(region);
+	}
+
+	//Only the rows of ropes that were added or removed are rebuilt
+	void SetRopes(const std::vector<NavRope>& newRopes) {
+		if (newRopes == ropes) return;
+
+		auto isMissingFrom = [](const NavRope& rope, const std::vector<NavRope>& others) {
+			return std::find(others.begin(), others.end(), rope) == others.end();
+		};
+		for (auto& rope : ropes) if (isMissingFrom(rope, newRopes)) Invalidate(GetRopeRegion(rope));
+		for (auto& rope : newRopes) if (isMissingFrom(rope, ropes)) Invalidate(GetRopeRegion(rope));
+
+		ropes = newRopes;
+		RebuildRopeSurface();
+	}
+
+	//Brings the graph up to date with the level and ropes. FindPath calls it, so edits
+	//cost nothing until a path is needed.
+	void Refresh() {
+		if (level.GetWidth() != width || level.GetHeight() != height) Resize();
+
+		LevelRegion changed = Clamp(pending);
+		pending = LevelRegion();
+		if (changed.IsEmpty()) return;
+
+		//Whether a cell can be stood in depends on it and the tile below it
+		for (uint32_t i = changed.top > 0 ? changed.top - 1 : 0; i < changed.bottom; i++) {
+			for (uint32_t j = changed.left; j < changed.right; j++) {
+				isStandable[GetCell(j, i)] = ComputeStandable(j, i);
+			}
+		}
+
+		//Nodes beside the change may gain or lose walks and falls, the rest only if a move passes through it
+		LevelRegion beside = Clamp(LevelRegion(changed.left > 0 ? changed.left - 1 : 0, changed.top > 0 ? changed.top - 1 : 0, changed.right + 1, changed.bottom + 1));
+		std::vector<uint32_t> rebuilt;
+		for (uint32_t i = 0; i < height; i++) {
+			for (uint32_t j = 0; j < width; j++) {
+				uint32_t cell = GetCell(j, i);
+				bool isBeside = j >= beside.left && j < beside.right && i >= beside.top && i < beside.bottom;
+				if (isBeside || Intersects(reach[cell], changed)) rebuilt.push_back(cell);
+			}
+		}
+
+		if (pool) pool->ParallelFor(rebuilt.size(), [&](std::size_t i) { BuildNode(rebuilt[i]); });
+		else for (uint32_t cell : rebuilt) BuildNode(cell);
+
+		pathCache.clear();
+	}
+
+	//Cheapest moves from one node to another, nullptr if there is no way. Valid until the
+	//next call that changes the graph.
+	const std::vector<NavEdge>* FindPath(uint32_t start, uint32_t goal) {
+		Refresh();
+		if (start >= isStandable.size() || goal >= isStandable.size() || !isStandable[start] || !isStandable[goal]) return nullptr;
+
+		uint64_t key = ((uint64_t)start << 32) | goal;
+		auto cached = pathCache.find(key);
+		if (cached == pathCache.end()) {
+			if (pathCache.size() >= maxCachedPaths) pathCache.clear();
+
+			CachedPath& path = pathCache[key];
+			path.isFound = Search(start, goal, path.edges);
+			return path.isFound ? &path.edges : nullptr;
+		}
+
+		return cached->second.isFound ? &cached->second.edges : nullptr;
+	}
+
+	//Node an agent at the position stands in, or is falling towards; -1 if none is close below it
+	int64_t FindNode(const sf::Vector2f& position) {
+		const int maxDrop = 8;
+		Refresh();
+
+		int x = (int)std::floor((position.x + params.size / 2.0f) / params.size);
+		int y = (int)std::floor((position.y + params.size / 2.0f) / params.size);
+		for (int i = y; i < y + maxDrop && i < (int)height; i++) {
+			if (!IsInside(x, i) || (GetTileFlags(x, i) & TileSolid)) break;
+			if (isStandable[GetCell(x, i)]) return GetCell(x, i);
+		}
+		return -1;
+	}
+
+	inline sf::Vector2f GetCellPosition(uint32_t cell) const { return { (cell % width) * params.size, (cell / width) * params.size }; }
+	inline const std::vector<NavEdge>& GetEdges(uint32_t cell) const { return edges[cell]; }
+	inline bool IsStandable(uint32_t cell) const { return isStandable[cell]; }
+	inline uint32_t GetNodeCount() const { return (uint32_t)isStandable.size(); }
+};
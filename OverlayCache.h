@@ -0,0 +1,114 @@
+#pragma once
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
+#include <SFML/Graphics/View.hpp>
+#include <vector>
+#include <cmath>
+
+//Editor overlays that rarely change (the tile grid and the outline of the level), kept in a
+//static vertex buffer and drawn in one call. The geometry is rebuilt only when the window
+//size, the cell size, the view or the bounds change.
+class OverlayCache {
+private:
+	sf::VertexBuffer buffer;
+	std::vector<sf::Vertex> vertices;
+	bool isBufferUsable;
+
+	sf::Vector2u windowSize;
+	sf::Vector2f viewCenter, viewSize;
+	float viewRotation;
+
+	float cellSize;
+	sf::FloatRect bounds;
+	sf::Color gridColor, outlineColor;
+	bool isDirty;
+
+	void AddLine(float x1, float y1, float x2, float y2, sf::Color color) {
+		vertices.emplace_back(sf::Vector2f(x1, y1), color);
+		vertices.emplace_back(sf::Vector2f(x2, y2), color);
+	}
+
+	//Area of the world the view shows, grown to cover it when the view is rotated
+	sf::FloatRect GetVisibleArea() const {
+		float radians = viewRotation * 3.14159265f / 180.0f;
+		float c = std::fabs(std::cos(radians)), s = std::fabs(std::sin(radians));
+		float w = viewSize.x * c + viewSize.y * s;
+		float h = viewSize.x * s + viewSize.y * c;
+
+		return { viewCenter.x - w / 2.0f, viewCenter.y - h / 2.0f, w, h };
+	}
+
+	void Rebuild() {
+		vertices.clear();
+
+		sf::FloatRect area;
+		if (cellSize > 0.0f && GetVisibleArea().intersects(bounds, area)) {
+			float left = bounds.left + std::ceil((area.left - bounds.left) / cellSize) * cellSize;
+			float top = bounds.top + std::ceil((area.top - bounds.top) / cellSize) * cellSize;
+			float right = area.left + area.width, bottom = area.top + area.height;
+
+			for (float x = left; x <= right; x += cellSize) AddLine(x, area.top, x, bottom, gridColor);
+			for (float y = top; y <= bottom; y += cellSize) AddLine(area.left, y, right, y, gridColor);
+		}
+
+		if (bounds.width > 0.0f && bounds.height > 0.0f) {
+			float right = bounds.left + bounds.width, bottom = bounds.top + bounds.height;
+			AddLine(bounds.left, bounds.top, right, bounds.top, outlineColor);
+			AddLine(right, bounds.top, right, bottom, outlineColor);
+			AddLine(right, bottom, bounds.left, bottom, outlineColor);
+			AddLine(bounds.left, bottom, bounds.left, bounds.top, outlineColor);
+		}
+
+		if (isBufferUsable) {
+			isBufferUsable = buffer.create(vertices.size()) && (vertices.empty() || buffer.update(vertices.data()));
+		}
+		isDirty = false;
+	}
+public:
+	OverlayCache()
+		: buffer(sf::Lines, sf::VertexBuffer::Static) {
+		isBufferUsable = sf::VertexBuffer::isAvailable();
+
+		viewRotation = 0.0f;
+		cellSize = 32.0f;
+		gridColor = sf::Color(255, 255, 255, 40);
+		outlineColor = sf::Color(255, 255, 255, 120);
+		isDirty = true;
+	}
+
+	void SetCellSize(float size) {
+		isDirty = isDirty || size != cellSize;
+		cellSize = size;
+	}
+
+	//Area the grid is drawn in and outlined, in world coordinates
+	void SetBounds(const sf::FloatRect& area) {
+		isDirty = isDirty || area != bounds;
+		bounds = area;
+	}
+
+	void SetColors(sf::Color grid, sf::Color outline) {
+		gridColor = grid;
+		outlineColor = outline;
+		isDirty = true;
+	}
+
+	void Render(sf::RenderWindow& window) {
+		const sf::View& view = window.getView();
+		sf::Vector2u size = window.getSize();
+
+		if (size != windowSize || view.getCenter() != viewCenter || view.getSize() != viewSize || view.getRotation() != viewRotation) {
+			windowSize = size;
+			viewCenter = view.getCenter();
+			viewSize = view.getSize();
+			viewRotation = view.getRotation();
+			isDirty = true;
+		}
+
+		if (isDirty) Rebuild();
+		if (vertices.empty()) return;
+
+		if (isBufferUsable) window.draw(buffer);
+		else window.draw(vertices.data(), vertices.size(), sf::Lines);
+	}
+};
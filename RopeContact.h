@@ -0,0 +1,105 @@
+#pragma once
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+struct RopeContact {
+	bool isHit = false;
+	sf::Vector2f point;
+	float t = 0.0f; //Parameter along the rope, 0 at its first point and 1 at its last
+	int segment = -1;
+};
+
+//Slab test of count segments (x1[i], y1[i]) -> (x2[i], y2[i]) against box, without branches.
+//tOut[i] receives the parameter in [0, 1] at which segment i enters the box, or 2 if it misses.
+inline void IntersectSegmentsAABB(const float* x1, const float* y1, const float* x2, const float* y2, std::size_t count, const sf::FloatRect& box, float* tOut) {
+	float left = box.left, right = box.left + box.width;
+	float top = box.top, bottom = box.top + box.height;
+
+	for (std::size_t i = 0; i < count; i++) {
+		float dx = x2[i] - x1[i];
+		float dy = y2[i] - y1[i];
+		float invDx = 1.0f / (std::fabs(dx) > 1e-8f ? dx : 1e-8f);
+		float invDy = 1.0f / (std::fabs(dy) > 1e-8f ? dy : 1e-8f);
+
+		float tx1 = (left - x1[i]) * invDx, tx2 = (right - x1[i]) * invDx;
+		float ty1 = (top - y1[i]) * invDy, ty2 = (bottom - y1[i]) * invDy;
+
+		float tEnter = std::fmax(std::fmax(std::fmin(tx1, tx2), std::fmin(ty1, ty2)), 0.0f);
+		float tExit = std::fmin(std::fmin(std::fmax(tx1, tx2), std::fmax(ty1, ty2)), 1.0f);
+
+		tOut[i] = tEnter <= tExit ? tEnter : 2.0f;
+	}
+}
+
+//First segment of a polyline that entered the box, from the parameters written by IntersectSegmentsAABB
+inline RopeContact FirstContact(const float* xs, const float* ys, std::size_t nPoints, const float* segmentT) {
+	RopeContact contact;
+
+	for (std::size_t s = 0; s + 1 < nPoints; s++) {
+		if (segmentT[s] > 1.0f) continue;
+
+		float t = segmentT[s];
+		contact.isHit = true;
+		contact.segment = (int)s;
+		contact.point = { xs[s] + (xs[s + 1] - xs[s]) * t, ys[s] + (ys[s + 1] - ys[s]) * t };
+		contact.t = ((float)s + t) / (float)(nPoints - 1);
+		break;
+	}
+
+	return contact;
+}
+
+//Contact of a single polyline with box. scratch must hold nPoints - 1 floats.
+inline RopeContact FindPolylineContact(const float* xs, const float* ys, std::size_t nPoints, const sf::FloatRect& box, float* scratch) {
+	if (nPoints < 2) return RopeContact();
+
+	IntersectSegmentsAABB(xs, ys, xs + 1, ys + 1, nPoints - 1, box, scratch);
+	return FirstContact(xs, ys, nPoints, scratch);
+}
+
+//Polylines of many ropes packed back to back, so one box can be tested against all of
+//them in a single pass. The segment joining two neighbouring ropes is tested but ignored.
+class SegmentBatch {
+private:
+	std::vector<float> xs, ys, segmentT;
+	std::vector<std::size_t> ropeStart;
+public:
+	SegmentBatch() {
+		ropeStart.push_back(0);
+	}
+
+	void Clear() {
+		xs.clear();
+		ys.clear();
+		ropeStart.assign(1, 0);
+	}
+
+	void AddPolyline(const float* x, const float* y, std::size_t nPoints) {
+		xs.insert(xs.end(), x, x + nPoints);
+		ys.insert(ys.end(), y, y + nPoints);
+		ropeStart.push_back(xs.size());
+	}
+
+	//Fills contacts with one entry per added polyline, in the order they were added
+	void Test(const sf::FloatRect& box, std::vector<RopeContact>& contacts) {
+		std::size_t nRopes = ropeStart.size() - 1;
+		contacts.resize(nRopes);
+		if (xs.size() < 2) {
+			for (auto& contact : contacts) contact = RopeContact();
+			return;
+		}
+
+		segmentT.resize(xs.size() - 1);
+		IntersectSegmentsAABB(xs.data(), ys.data(), xs.data() + 1, ys.data() + 1, xs.size() - 1, box, segmentT.data());
+
+		for (std::size_t r = 0; r < nRopes; r++) {
+			std::size_t first = ropeStart[r];
+			contacts[r] = FirstContact(xs.data() + first, ys.data() + first, ropeStart[r + 1] - first, segmentT.data() + first);
+		}
+	}
+
+	inline std::size_t GetRopeCount() const { return ropeStart.size() - 1; }
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <SFML/Graphics/Rect.hpp>
+#include <vector>
+#include <cstdint>
+
+//Group of ropes that may interact through shared agents and therefore
+//have to be solved serially, in their original order
+struct RopeIsland {
+	std::vector<uint32_t> agents;
+	std::vector<uint32_t> ropes;
+};
+
+//Partitions ropes into independent islands. Ropes never touch each other, so two
+//ropes only depend on each other if they can both reach the same agent this tick.
+class RopeIslands {
+private:
+	std::vector<uint32_t> parent;
+	std::vector<int> islandOfRoot;
+	std::vector<int> ropeAgent;
+
+	std::vector<RopeIsland> islands;
+	std::vector<uint32_t> freeRopes;
+
+	uint32_t Find(uint32_t a) {
+		while (parent[a] != a) {
+			parent[a] = parent[parent[a]];
+			a = parent[a];
+		}
+		return a;
+	}
+
+	static bool Overlaps(const sf::FloatRect& a, const sf::FloatRect& b, float margin) {
+		return a.left - margin < b.left + b.width && b.left < a.left + a.width + margin &&
+			a.top - margin < b.top + b.height && b.top < a.top + a.height + margin;
+	}
+public:
+	//margin must cover the furthest a rope can move an agent within one tick, so that a rope
+	//outside an agent's island cannot be reached by it once other ropes have moved it
+	void Build(const std::vector<sf::FloatRect>& ropeBounds, const std::vector<sf::FloatRect>& agentBounds, float margin) {
+		uint32_t nAgents = (uint32_t)agentBounds.size();
+
+		parent.resize(nAgents);
+		for (uint32_t i = 0; i < nAgents; i++) parent[i] = i;
+
+		ropeAgent.assign(ropeBounds.size(), -1);
+		for (std::size_t r = 0; r < ropeBounds.size(); r++) {
+			for (uint32_t a = 0; a < nAgents; a++) {
+				if (!Overlaps(ropeBounds[r], agentBounds[a], margin)) continue;
+
+				if (ropeAgent[r] < 0) ropeAgent[r] = (int)a;
+				else parent[Find(a)] = Find((uint32_t)ropeAgent[r]);
+			}
+		}
+
+		islands.clear();
+		freeRopes.clear();
+		islandOfRoot.assign(nAgents, -1);
+
+		for (uint32_t a = 0; a < nAgents; a++) {
+			uint32_t root = Find(a);
+			if (islandOfRoot[root] < 0) {
+				islandOfRoot[root] = (int)islands.size();
+				islands.emplace_back();
+			}
+			islands[islandOfRoot[root]].agents.push_back(a);
+		}
+
+		for (std::size_t r = 0; r < ropeBounds.size(); r++) {
+			if (ropeAgent[r] < 0) freeRopes.push_back((uint32_t)r);
+			else islands[islandOfRoot[Find((uint32_t)ropeAgent[r])]].ropes.push_back((uint32_t)r);
+		}
+	}
+
+	//Islands holding at least one agent, with their ropes in ascending order
+	inline const std::vector<RopeIsland>& GetIslands() const { return islands; }
+	//Ropes no agent can reach; every one of them is an island of its own
+	inline const std::vector<uint32_t>& GetFreeRopes() const { return freeRopes; }
+};
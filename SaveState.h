@@ -0,0 +1,164 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+//Binary snapshots of the game state. Values are written as their raw bytes in the host's
+//byte order, so a state file is only meant to be read back on the same kind of machine.
+const uint32_t stateMagic = 0x56535253;  //"SRSV"
+const uint32_t stateVersion = 1;
+
+class StateWriter {
+private:
+	std::vector<uint8_t>& bytes;
+public:
+	//Appends to the buffer; clearing it first keeps its capacity, so reused buffers don't allocate
+	StateWriter(std::vector<uint8_t>& buffer)
+		: bytes(buffer) {}
+
+	void WriteBytes(const void* data, std::size_t size) {
+		const uint8_t* begin = (const uint8_t*)data;
+		bytes.insert(bytes.end(), begin, begin + size);
+	}
+
+	template<typename T>
+	void Write(const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be written directly");
+		WriteBytes(&value, sizeof(T));
+	}
+
+	template<typename T>
+	void WriteArray(const std::vector<T>& values) {
+		Write((uint32_t)values.size());
+		WriteBytes(values.data(), values.size() * sizeof(T));
+	}
+
+	void WriteString(const std::string& value) {
+		Write((uint32_t)value.size());
+		WriteBytes(value.data(), value.size());
+	}
+
+	void WriteHeader() {
+		Write(stateMagic);
+		Write(stateVersion);
+	}
+};
+
+//Reads what StateWriter wrote. Reading past the end or a count that can't fit marks the
+//reader invalid, and every later read fails too.
+class StateReader {
+private:
+	const uint8_t* data;
+	std::size_t size, offset;
+	bool isValid;
+public:
+	StateReader(const std::vector<uint8_t>& bytes)
+		: data(bytes.data()), size(bytes.size()), offset(0), isValid(true) {}
+
+	bool ReadBytes(void* out, std::size_t count) {
+		if (!isValid || count > size - offset) return isValid = false;
+
+		std::memcpy(out, data + offset, count);
+		offset += count;
+		return true;
+	}
+
+	template<typename T>
+	bool Read(T& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be read directly");
+		return ReadBytes(&value, sizeof(T));
+	}
+
+	//Reads the next value without moving past it
+	template<typename T>
+	bool Peek(T& value) const {
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be read directly");
+		if (!isValid || sizeof(T) > size - offset) return false;
+
+		std::memcpy(&value, data + offset, sizeof(T));
+		return true;
+	}
+
+	template<typename T>
+	bool ReadArray(std::vector<T>& values) {
+		uint32_t count = 0;
+		if (!Read(count) || count > (size - offset) / sizeof(T)) return isValid = false;
+
+		values.resize(count);
+		return ReadBytes(values.data(), count * sizeof(T));
+	}
+
+	bool ReadString(std::string& value) {
+		uint32_t count = 0;
+		if (!Read(count) || count > size - offset) return isValid = false;
+
+		value.resize(count);
+		return ReadBytes(&value[0], count);
+	}
+
+	//Version of the state, 0 if it isn't one
+	uint32_t ReadHeader() {
+		uint32_t magic = 0, version = 0;
+		if (!Read(magic) || !Read(version) || magic != stateMagic) return 0;
+		return version;
+	}
+
+	inline bool IsValid() const { return isValid; }
+	inline std::size_t GetRemaining() const { return size - offset; }
+};
+
+//Fixed number of states in memory, newest replacing oldest. The slots keep their
+//buffers, so recording doesn't allocate once every slot has been used.
+class StateRing {
+private:
+	std::vector<std::vector<uint8_t>> slots;
+	std::size_t head, count;
+public:
+	StateRing(std::size_t capacity = 150)
+		: slots(capacity), head(0), count(0) {}
+
+	//Empty buffer to write the next state into
+	std::vector<uint8_t>& Push() {
+		std::vector<uint8_t>& slot = slots[head];
+		head = (head + 1) % slots.size();
+		count = std::min(count + 1, slots.size());
+
+		slot.clear();
+		return slot;
+	}
+
+	//Newest state, removed from the ring; nullptr if empty. Valid until the next Push.
+	const std::vector<uint8_t>* Pop() {
+		if (count == 0) return nullptr;
+
+		head = (head + slots.size() - 1) % slots.size();
+		count--;
+		return &slots[head];
+	}
+
+	void Clear() { count = 0; }
+
+	inline std::size_t GetCount() const { return count; }
+};
+
+inline bool SaveStateFile(const std::string& filepath, const std::vector<uint8_t>& bytes) {
+	std::ofstream writer(filepath, std::ios::binary);
+	if (!writer.is_open()) return false;
+
+	writer.write((const char*)bytes.data(), bytes.size());
+	return (bool)writer;
+}
+
+inline bool LoadStateFile(const std::string& filepath, std::vector<uint8_t>& bytes) {
+	std::ifstream reader(filepath, std::ios::binary | std::ios::ate);
+	if (!reader.is_open()) return false;
+
+	bytes.resize((std::size_t)reader.tellg());
+	reader.seekg(0);
+	reader.read((char*)bytes.data(), bytes.size());
+	return (bool)reader;
+}
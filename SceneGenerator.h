@@ -0,0 +1,188 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+//Small PCG generator. The standard distributions differ between library implementations,
+//so every number the generator draws comes from here to keep a seed's scene identical everywhere.
+class SceneRandom {
+private:
+	uint64_t state;
+public:
+	SceneRandom(uint64_t seed) {
+		state = 0;
+		Next();
+		state += seed;
+		Next();
+	}
+
+	uint32_t Next() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint32_t shifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+		uint32_t rotation = (uint32_t)(old >> 59);
+		return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+	}
+
+	//Integer in [low, high]
+	int32_t Range(int32_t low, int32_t high) {
+		return low + (int32_t)(Next() % (uint32_t)(high - low + 1));
+	}
+
+	bool Chance(float probability) {
+		return (Next() >> 8) * (1.0f / 16777216.0f) < probability;
+	}
+};
+
+struct StressSceneParams {
+	uint64_t seed = 1;
+	uint32_t width = 128, height = 128;  //Tiles
+	float tileSize = 32.0f;
+
+	float platformDensity = 0.12f;       //Platforms per tile row, per 16 tiles of width
+	float wallDensity = 0.03f;
+	float hazardChance = 0.05f;          //Chance a platform carries hazards
+
+	uint32_t ropeCount = 2000;
+	float bounceFraction = 0.3f;         //The rest are plain ropes
+	uint32_t verletCount = 0;            //Ropes made Verlet ropes instead, whatever their kind
+	uint32_t agentCount = 0;
+};
+
+struct RopeSpawn {
+	int type;  //StringRopeMain::StringType
+	sf::Vector2f position;
+	float length;
+};
+
+//One step of an agent's looping script
+struct AgentStep {
+	uint16_t ticks;
+	int8_t direction;
+	bool isJumping;
+};
+
+struct AgentSpawn {
+	sf::Vector2f position;
+	std::vector<AgentStep> script;
+};
+
+struct StressScene {
+	uint32_t width = 0, height = 0;
+	std::vector<std::string> rows;
+	std::vector<RopeSpawn> ropes;
+	std::vector<AgentSpawn> agents;
+	sf::Vector2f playerSpawn;
+};
+
+//Builds the same scene for the same parameters on every run and platform
+class SceneGenerator {
+private:
+	static bool IsAreaEmpty(const StressScene& scene, uint32_t left, uint32_t top, uint32_t right, uint32_t bottom) {
+		for (uint32_t i = top; i < bottom; i++) {
+			for (uint32_t j = left; j < right; j++) {
+				if (scene.rows[i][j] != '.') return false;
+			}
+		}
+		return true;
+	}
+
+	static void GenerateLevel(const StressSceneParams& params, SceneRandom& random, StressScene& scene) {
+		uint32_t w = scene.width, h = scene.height;
+		scene.rows.assign(h, std::string(w, '.'));
+
+		for (uint32_t j = 0; j < w; j++) scene.rows[0][j] = scene.rows[h - 1][j] = '#';
+		for (uint32_t i = 0; i < h; i++) scene.rows[i][0] = scene.rows[i][w - 1] = '#';
+
+		//Horizontal platforms, some one-way, a few with hazards on top
+		uint32_t nPlatforms = (uint32_t)(params.platformDensity * h * (w / 16.0f));
+		for (uint32_t n = 0; n < nPlatforms; n++) {
+			uint32_t y = (uint32_t)random.Range(3, h - 2);
+			uint32_t length = (uint32_t)random.Range(3, 12);
+			uint32_t x = (uint32_t)random.Range(1, std::max(1, (int32_t)(w - 1 - length)));
+			char c = random.Chance(0.25f) ? '=' : '#';
+			bool hasHazard = c == '#' && random.Chance(params.hazardChance);
+
+			for (uint32_t j = x; j < std::min(x + length, w - 1); j++) {
+				scene.rows[y][j] = c;
+				if (hasHazard && (j - x) % 3 == 1 && scene.rows[y - 1][j] == '.') scene.rows[y - 1][j] = '^';
+			}
+		}
+
+		uint32_t nWalls = (uint32_t)(params.wallDensity * w * (h / 16.0f));
+		for (uint32_t n = 0; n < nWalls; n++) {
+			uint32_t x = (uint32_t)random.Range(2, w - 3);
+			uint32_t length = (uint32_t)random.Range(2, 8);
+			uint32_t y = (uint32_t)random.Range(1, std::max(1, (int32_t)(h - 1 - length)));
+
+			for (uint32_t i = y; i < std::min(y + length, h - 1); i++) scene.rows[i][x] = '#';
+		}
+
+		//Keep the corner the player starts in open
+		for (uint32_t i = 1; i < std::min(5u, h - 1); i++) {
+			for (uint32_t j = 1; j < std::min(5u, w - 1); j++) scene.rows[i][j] = '.';
+		}
+		scene.playerSpawn = { params.tileSize, params.tileSize };
+	}
+
+	static void PlaceRopes(const StressSceneParams& params, SceneRandom& random, StressScene& scene) {
+		const int maxAttempts = 16;
+
+		for (uint32_t n = 0; n < params.ropeCount; n++) {
+			for (int attempt = 0; attempt < maxAttempts; attempt++) {
+				uint32_t length = (uint32_t)random.Range(2, 8);
+				if (length + 2 >= scene.width) break;
+
+				uint32_t x = (uint32_t)random.Range(1, scene.width - 1 - length);
+				uint32_t y = (uint32_t)random.Range(2, scene.height - 3);
+
+				//Room for the rope and its sag below it
+				if (!IsAreaEmpty(scene, x, y, x + length, y + 2)) continue;
+
+				int type = random.Chance(params.bounceFraction) ? 1 : 0;
+				if (n < params.verletCount) type = 2;
+				scene.ropes.push_back({ type, { x * params.tileSize, y * params.tileSize }, length * params.tileSize });
+				break;
+			}
+		}
+	}
+
+	static void PlaceAgents(const StressSceneParams& params, SceneRandom& random, StressScene& scene) {
+		const int maxAttempts = 64;
+
+		for (uint32_t n = 0; n < params.agentCount; n++) {
+			for (int attempt = 0; attempt < maxAttempts; attempt++) {
+				uint32_t x = (uint32_t)random.Range(1, scene.width - 2);
+				uint32_t y = (uint32_t)random.Range(1, scene.height - 2);
+				if (!IsAreaEmpty(scene, x, y, x + 1, y + 1)) continue;
+
+				AgentSpawn agent;
+				agent.position = { x * params.tileSize, y * params.tileSize };
+
+				int nSteps = random.Range(2, 6);
+				for (int s = 0; s < nSteps; s++) {
+					agent.script.push_back({ (uint16_t)random.Range(10, 120), (int8_t)random.Range(-1, 1), random.Chance(0.3f) });
+				}
+
+				scene.agents.push_back(std::move(agent));
+				break;
+			}
+		}
+	}
+public:
+	static StressScene Generate(const StressSceneParams& params) {
+		SceneRandom random(params.seed);
+
+		StressScene scene;
+		scene.width = std::max(params.width, 8u);
+		scene.height = std::max(params.height, 8u);
+
+		GenerateLevel(params, random, scene);
+		PlaceRopes(params, random, scene);
+		PlaceAgents(params, random, scene);
+
+		return scene;
+	}
+};
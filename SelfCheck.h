@@ -0,0 +1,209 @@
+#pragma once
+#include "GraphicsRender.h"
+#include "LevelQuery.h"
+#include "NavGraph.h"
+#include "SceneGenerator.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <ostream>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+//Checks of the fast paths that have a slow but plainly right counterpart, run with --check.
+//Each one prints what it compared and returns false if anything differed.
+class SelfCheck {
+private:
+	//Float in [low, high)
+	static float RandomFloat(SceneRandom& random, float low, float high) {
+		return low + (high - low) * (float)(random.Next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	//Nearest matching tile the ray passes through the inside of, found by clipping the ray
+	//against every tile in its bounding box
+	template<typename LevelType>
+	static RayHit BruteForceRaycast(const LevelType& level, float tileSize, const RayQuery& query) {
+		const float infinity = std::numeric_limits<float>::infinity();
+		RayHit hit;
+
+		sf::Vector2f d = query.direction;
+		float length = std::sqrt(d.x * d.x + d.y * d.y);
+		if (length > 0.0f) d /= length;
+		sf::Vector2f end = query.origin + d * query.maxDistance;
+
+		int left = std::max((int)std::floor(std::fmin(query.origin.x, end.x) / tileSize) - 1, 0);
+		int top = std::max((int)std::floor(std::fmin(query.origin.y, end.y) / tileSize) - 1, 0);
+		int right = std::min((int)std::floor(std::fmax(query.origin.x, end.x) / tileSize) + 1, (int)level.GetWidth() - 1);
+		int bottom = std::min((int)std::floor(std::fmax(query.origin.y, end.y) / tileSize) + 1, (int)level.GetHeight() - 1);
+
+		//Distances along the ray at which it is between the two borders on one axis
+		auto clip = [&](float origin, float direction, float low, float high, float& enter, float& exit) {
+			if (direction == 0.0f) {
+				bool isInside = origin >= low && origin < high;
+				enter = isInside ? -infinity : infinity;
+				exit = isInside ? infinity : -infinity;
+				return;
+			}
+
+			enter = (low - origin) / direction;
+			exit = (high - origin) / direction;
+			if (enter > exit) std::swap(enter, exit);
+		};
+
+		const TileRegistry& registry = TileRegistry::Get();
+		for (int i = top; i <= bottom; i++) {
+			for (int j = left; j <= right; j++) {
+				if (!(registry.GetFlags(level.GetCharacter(j, i)) & query.mask)) continue;
+
+				float enterX, exitX, enterY, exitY;
+				clip(query.origin.x, d.x, j * tileSize, (j + 1) * tileSize, enterX, exitX);
+				clip(query.origin.y, d.y, i * tileSize, (i + 1) * tileSize, enterY, exitY);
+
+				float enter = std::fmax(std::fmax(enterX, enterY), 0.0f), exit = std::fmin(exitX, exitY);
+				if (enter >= exit || enter > query.maxDistance) continue;
+				if (hit.isHit && enter >= hit.distance) continue;
+
+				hit.isHit = true;
+				hit.tile = { j, i };
+				hit.distance = enter;
+			}
+		}
+
+		return hit;
+	}
+
+	static bool IsSameEdge(const NavEdge& a, const NavEdge& b) {
+		return a.target == b.target && a.cost == b.cost && a.move == b.move &&
+			a.direction == b.direction && a.moveStart == b.moveStart && a.moveEnd == b.moveEnd;
+	}
+
+	static uint32_t CountDifferentNodes(const NavGraph<Level>& a, const NavGraph<Level>& b) {
+		if (a.GetNodeCount() != b.GetNodeCount()) return std::max(a.GetNodeCount(), b.GetNodeCount());
+
+		uint32_t count = 0;
+		for (uint32_t cell = 0; cell < a.GetNodeCount(); cell++) {
+			const std::vector<NavEdge>& edgesA = a.GetEdges(cell);
+			const std::vector<NavEdge>& edgesB = b.GetEdges(cell);
+
+			bool isSame = a.IsStandable(cell) == b.IsStandable(cell) && edgesA.size() == edgesB.size() &&
+				std::equal(edgesA.begin(), edgesA.end(), edgesB.begin(), IsSameEdge);
+			count += !isSame;
+		}
+		return count;
+	}
+public:
+	//Raycasts through the grid, one at a time and batched, against the brute force search.
+	//A ray that only grazes a tile within tolerance of its end or of a corner may go either way.
+	template<typename LevelType>
+	static bool CheckRaycasts(const LevelType& level, float tileSize, ThreadPool& pool, uint32_t count, uint64_t seed, std::ostream& out) {
+		const float tolerance = 0.01f * tileSize;
+		const float pi = 3.14159265f;
+
+		SceneRandom random(seed);
+		float levelWidth = level.GetWidth() * tileSize, levelHeight = level.GetHeight() * tileSize;
+		float diagonal = std::sqrt(levelWidth * levelWidth + levelHeight * levelHeight);
+
+		std::vector<RayQuery> queries(count);
+		for (auto& query : queries) {
+			float angle = RandomFloat(random, 0.0f, 2.0f * pi);
+			query.origin = { RandomFloat(random, 0.0f, levelWidth), RandomFloat(random, 0.0f, levelHeight) };
+			query.direction = { std::cos(angle), std::sin(angle) };
+			query.maxDistance = RandomFloat(random, 0.0f, diagonal);
+			query.mask = random.Chance(0.5f) ? TileSolid : (uint8_t)(TileSolid | TileOneWay | TileHazard);
+		}
+
+		LevelQuery<LevelType> levelQuery(level, tileSize);
+		std::vector<RayHit> hits(count);
+		levelQuery.RaycastBatch(pool, queries.data(), hits.data(), count);
+
+		uint32_t hitCount = 0, mismatches = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			const RayQuery& query = queries[i];
+			RayHit single = levelQuery.Raycast(query.origin, query.direction, query.maxDistance, query.mask);
+			RayHit expected = BruteForceRaycast(level, tileSize, query);
+			hitCount += expected.isHit;
+
+			bool isBatchSame = single.isHit == hits[i].isHit && single.tile == hits[i].tile && single.distance == hits[i].distance;
+			bool isSame = single.isHit == expected.isHit && (!single.isHit || std::fabs(single.distance - expected.distance) <= tolerance);
+			bool isNearEnd = std::fabs((single.isHit ? single.distance : expected.distance) - query.maxDistance) <= tolerance;
+
+			if (isBatchSame && (isSame || isNearEnd)) continue;
+			if (mismatches++ < 8) {
+				out << "Raycast " << i << " from (" << query.origin.x << ", " << query.origin.y << ") towards ("
+					<< query.direction.x << ", " << query.direction.y << "): grid walk " << (single.isHit ? single.distance : -1.0f)
+					<< ", batched " << (hits[i].isHit ? hits[i].distance : -1.0f)
+					<< ", brute force " << (expected.isHit ? expected.distance : -1.0f) << std::endl;
+			}
+		}
+
+		out << "Raycasts: " << count << " compared, " << hitCount << " hits, " << mismatches << " mismatches" << std::endl;
+		return mismatches == 0;
+	}
+
+	//Applies random tile edits, and every fourth time adds a rope of any kind or removes one,
+	//refreshing the graph after each. The result is compared against a graph built from
+	//scratch for the same level and ropes, and the mean time of both is printed.
+	static bool CheckNavGraph(const Level& sourceLevel, const NavParams& params, const std::vector<NavRope>& sourceRopes,
+		ThreadPool& pool, uint32_t edits, uint64_t seed, std::ostream& out) {
+		using Clock = std::chrono::steady_clock;
+		auto milliseconds = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+		const char tiles[] = { '.', '#', '=', '^' };
+
+		SceneRandom random(seed);
+		Level level = sourceLevel;
+		level.TakeDirtyRegion();
+		std::vector<NavRope> ropes = sourceRopes;
+		int width = (int)level.GetWidth(), height = (int)level.GetHeight();
+
+		NavGraph<Level> graph(level, &pool);
+		graph.SetParams(params);
+		graph.SetRopes(ropes);
+		graph.Refresh();
+
+		double refreshTime = 0.0, buildTime = 0.0;
+		uint32_t mismatches = 0;
+		for (uint32_t k = 0; k < edits; k++) {
+			int x = random.Range(0, width - 1), y = random.Range(0, height - 1);
+			level.FillRect(x, y, x + random.Range(1, 3), y + random.Range(1, 2), tiles[random.Range(0, 3)]);
+
+			if (k % 4 == 3 && !ropes.empty()) {
+				uint32_t index = (uint32_t)random.Range(0, (int32_t)ropes.size() - 1);
+				if (random.Chance(0.5f)) {
+					ropes.erase(ropes.begin() + index);
+				}
+				else {
+					NavRope rope = ropes[index];
+					rope.position.x += random.Range(-4, 4) * params.size;
+					rope.position.y += random.Range(-4, 4) * params.size;
+					rope.kind = (NavRopeKind)random.Range(0, 3);
+					ropes.push_back(rope);
+				}
+			}
+
+			auto start = Clock::now();
+			graph.Invalidate(level.TakeDirtyRegion());
+			graph.SetRopes(ropes);
+			graph.Refresh();
+			refreshTime += milliseconds(Clock::now() - start);
+
+			start = Clock::now();
+			NavGraph<Level> fresh(level, &pool);
+			fresh.SetParams(params);
+			fresh.SetRopes(ropes);
+			fresh.Refresh();
+			buildTime += milliseconds(Clock::now() - start);
+
+			uint32_t different = CountDifferentNodes(graph, fresh);
+			if (different > 0 && mismatches++ < 8) {
+				out << "Edit " << k << " at (" << x << ", " << y << "): " << different << " nodes differ from a fresh build" << std::endl;
+			}
+		}
+
+		out << "Navigation graph: " << edits << " edits on " << width << "x" << height << " tiles with "
+			<< pool.GetThreadCount() << " threads, " << mismatches << " mismatched. Mean refresh "
+			<< refreshTime / std::max(edits, 1u) << " ms, mean full build " << buildTime / std::max(edits, 1u) << " ms" << std::endl;
+		return mismatches == 0;
+	}
+};
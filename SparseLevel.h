@@ -0,0 +1,200 @@
+#pragma once
+#include "GraphicsRender.h"
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <cstdint>
+
+//Level stored as run-length encoded rows. Only runs of non-empty tiles are kept, so a
+//mostly empty world costs memory in proportion to what is actually in it.
+//Has the same tile interface as Level and can be used wherever Level is a template argument.
+class SparseLevel {
+private:
+	struct Run {
+		uint32_t start, length;
+		char c;
+
+		inline uint32_t End() const { return start + length; }
+	};
+
+	std::vector<std::vector<Run>> rows;
+	uint32_t width, height;
+	char emptyTile;
+
+	LevelRegion dirtyRegion;
+
+	//First run of the row ending after x
+	static std::vector<Run>::iterator FindRun(std::vector<Run>& row, uint32_t x) {
+		return std::upper_bound(row.begin(), row.end(), x, [](uint32_t value, const Run& run) { return value < run.End(); });
+	}
+
+	static std::vector<Run>::const_iterator FindRun(const std::vector<Run>& row, uint32_t x) {
+		return std::upper_bound(row.begin(), row.end(), x, [](uint32_t value, const Run& run) { return value < run.End(); });
+	}
+
+	//Overwrites [x1, x2) of a row with c, keeping runs sorted, disjoint and merged
+	void WriteSpan(std::vector<Run>& row, uint32_t x1, uint32_t x2, char c) {
+		auto first = FindRun(row, x1);
+		auto last = first;
+		while (last != row.end() && last->start < x2) last++;
+
+		//Parts of the overwritten runs sticking out on either side survive
+		Run head = { 0, 0, 0 }, tail = { 0, 0, 0 };
+		if (first != last && first->start < x1) head = { first->start, x1 - first->start, first->c };
+		if (first != last && (last - 1)->End() > x2) tail = { x2, (last - 1)->End() - x2, (last - 1)->c };
+
+		std::size_t index = first - row.begin();
+		row.erase(first, last);
+
+		Run pieces[3];
+		int nPieces = 0;
+		if (head.length > 0) pieces[nPieces++] = head;
+		if (c != emptyTile) pieces[nPieces++] = { x1, x2 - x1, c };
+		if (tail.length > 0) pieces[nPieces++] = tail;
+
+		row.insert(row.begin() + index, pieces, pieces + nPieces);
+
+		//Merge with equal neighbours around the written span
+		std::size_t begin = index > 0 ? index - 1 : 0;
+		std::size_t end = std::min(row.size(), index + nPieces + 1);
+		for (std::size_t i = begin; i + 1 < end && i + 1 < row.size();) {
+			if (row[i].End() == row[i + 1].start && row[i].c == row[i + 1].c) {
+				row[i].length += row[i + 1].length;
+				row.erase(row.begin() + i + 1);
+				end--;
+			}
+			else {
+				i++;
+			}
+		}
+	}
+public:
+	SparseLevel(char empty = '.') {
+		width = height = 0;
+		emptyTile = empty;
+	}
+
+	void SetSize(uint32_t w, uint32_t h) {
+		width = w;
+		height = h;
+		rows.assign(h, std::vector<Run>());
+		dirtyRegion = LevelRegion(0, 0, width, height);
+	}
+
+	inline char GetCharacter(uint32_t x, uint32_t y) const {
+		if (x >= width || y >= height) return '\0';
+
+		const std::vector<Run>& row = rows[y];
+		auto run = FindRun(row, x);
+		return (run != row.end() && run->start <= x) ? run->c : emptyTile;
+	}
+
+	void SetCharacter(uint32_t x, uint32_t y, char c) {
+		if (x >= width || y >= height) return;
+		if (GetCharacter(x, y) == c) return;
+
+		WriteSpan(rows[y], x, x + 1, c);
+		dirtyRegion.Expand(x, y);
+	}
+
+	//Writes c over [x1, x2) of row y in one step
+	void SetSpan(uint32_t y, uint32_t x1, uint32_t x2, char c) {
+		x2 = std::min(x2, width);
+		if (y >= height || x1 >= x2) return;
+
+		WriteSpan(rows[y], x1, x2, c);
+		dirtyRegion.Merge(LevelRegion(x1, y, x2, y + 1));
+	}
+
+	//Calls fn(y, x1, x2, c) for every run of non-empty tiles inside the region, row by row
+	template<typename Function>
+	void ForEachSpan(const LevelRegion& region, Function fn) const {
+		uint32_t bottom = std::min(region.bottom, height);
+		for (uint32_t y = region.top; y < bottom; y++) {
+			const std::vector<Run>& row = rows[y];
+			for (auto run = FindRun(row, region.left); run != row.end() && run->start < region.right; run++) {
+				fn(y, std::max(run->start, region.left), std::min(run->End(), region.right), run->c);
+			}
+		}
+	}
+
+	static SparseLevel LoadLevel(const std::list<Tile>& positions, uint32_t levelWidth, uint32_t levelHeight, char empty = '.') {
+		SparseLevel level(empty);
+		level.SetSize(levelWidth, levelHeight);
+
+		//Bucket by row, then sort by column; the stable sort keeps the last write to a cell last
+		std::vector<std::vector<std::pair<uint32_t, char>>> buckets(levelHeight);
+		for (auto& pos : positions) {
+			if (pos.x < 0 || pos.x >(int)(levelWidth - 1) || pos.y < 0 || pos.y >(int)(levelHeight - 1)) continue;
+			buckets[pos.y].push_back({ (uint32_t)pos.x, pos.tileCharacter });
+		}
+
+		for (uint32_t y = 0; y < levelHeight; y++) {
+			auto& bucket = buckets[y];
+			std::stable_sort(bucket.begin(), bucket.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+			std::vector<Run>& row = level.rows[y];
+			for (std::size_t i = 0; i < bucket.size(); i++) {
+				if (i + 1 < bucket.size() && bucket[i + 1].first == bucket[i].first) continue;
+
+				auto [x, c] = bucket[i];
+				if (c == empty) continue;
+
+				if (!row.empty() && row.back().End() == x && row.back().c == c) row.back().length++;
+				else row.push_back({ x, 1, c });
+			}
+		}
+
+		return level;
+	}
+
+	static SparseLevel FromLevel(const Level& dense, char empty = '.') {
+		SparseLevel level(empty);
+		level.SetSize(dense.GetWidth(), dense.GetHeight());
+
+		for (uint32_t y = 0; y < level.height; y++) {
+			std::vector<Run>& row = level.rows[y];
+			for (uint32_t x = 0; x < level.width; x++) {
+				char c = dense.GetCharacter(x, y);
+				if (c == empty) continue;
+
+				if (!row.empty() && row.back().End() == x && row.back().c == c) row.back().length++;
+				else row.push_back({ x, 1, c });
+			}
+		}
+
+		return level;
+	}
+
+	Level ToLevel() const {
+		Level level;
+		level.InitializeLevelString(width, height);
+
+		ForEachSpan(LevelRegion(0, 0, width, height), [&](uint32_t y, uint32_t x1, uint32_t x2, char c) {
+			for (uint32_t x = x1; x < x2; x++) level.SetCharacter(x, y, c);
+		});
+
+		return level;
+	}
+
+	LevelRegion TakeDirtyRegion() {
+		LevelRegion region = dirtyRegion;
+		dirtyRegion = LevelRegion();
+		return region;
+	}
+
+	std::size_t GetRunCount() const {
+		std::size_t count = 0;
+		for (auto& row : rows) count += row.size();
+		return count;
+	}
+
+	std::size_t GetMemoryUsage() const {
+		std::size_t bytes = sizeof(*this) + rows.capacity() * sizeof(std::vector<Run>);
+		for (auto& row : rows) bytes += row.capacity() * sizeof(Run);
+		return bytes;
+	}
+
+	inline uint32_t GetWidth() const { return width; }
+	inline uint32_t GetHeight() const { return height; }
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+//Bounded lock-free queue from one producer thread to one consumer thread. Each side keeps a
+//cached copy of the other side's index and only reloads it when the queue looks full or
+//empty, so in the common case pushing and popping touch no shared cache line but their own.
+template<typename T, std::size_t Capacity>
+class SpscQueue {
+private:
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+	static constexpr std::size_t mask = Capacity - 1;
+
+	T items[Capacity];
+
+	alignas(64) std::atomic<std::size_t> head;  //Next item to pop, written by the consumer
+	std::size_t cachedTail;
+
+	alignas(64) std::atomic<std::size_t> tail;  //Next slot to push into, written by the producer
+	std::size_t cachedHead;
+public:
+	SpscQueue() {
+		head = tail = 0;
+		cachedHead = cachedTail = 0;
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	//Producer side. Returns false if the queue is full.
+	bool TryPush(const T& item) {
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		if (t - cachedHead == Capacity) {
+			cachedHead = head.load(std::memory_order_acquire);
+			if (t - cachedHead == Capacity) return false;
+		}
+
+		items[t & mask] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	//Consumer side. Oldest item, or nullptr if the queue is empty; valid until Pop.
+	const T* Front() {
+		std::size_t h = head.load(std::memory_order_relaxed);
+		if (h == cachedTail) {
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (h == cachedTail) return nullptr;
+		}
+
+		return &items[h & mask];
+	}
+
+	//Consumer side, only after Front returned an item
+	void Pop() {
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	bool TryPop(T& item) {
+		const T* front = Front();
+		if (!front) return false;
+
+		item = *front;
+		Pop();
+		return true;
+	}
+};
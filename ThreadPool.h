@@ -0,0 +1,109 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+//Fixed set of worker threads that run index-parallel loops.
+//The calling thread takes part in every loop, so a pool of N threads uses N + 1 cores.
+class ThreadPool {
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+
+	const std::function<void(std::size_t)>* job;
+	std::size_t jobCount;
+	std::atomic<std::size_t> nextIndex;
+	uint32_t activeWorkers;
+	uint64_t generation;
+	bool isStopping;
+
+	void RunIndices() {
+		for (std::size_t i = nextIndex++; i < jobCount; i = nextIndex++) {
+			(*job)(i);
+		}
+	}
+
+	void WorkerLoop() {
+		uint64_t seenGeneration = 0;
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return isStopping || generation != seenGeneration; });
+				if (isStopping) return;
+				seenGeneration = generation;
+			}
+
+			RunIndices();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--activeWorkers == 0) done.notify_one();
+		}
+	}
+public:
+	ThreadPool(uint32_t threadCount = DefaultThreadCount()) {
+		job = nullptr;
+		jobCount = 0;
+		nextIndex = 0;
+		activeWorkers = 0;
+		generation = 0;
+		isStopping = false;
+
+		for (uint32_t i = 0; i < threadCount; i++) {
+			workers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	//Calls fn(i) for every i in [0, count) and returns once all of them have finished
+	void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& fn) {
+		if (count == 0) return;
+		if (workers.empty() || count == 1) {
+			for (std::size_t i = 0; i < count; i++) fn(i);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &fn;
+			jobCount = count;
+			nextIndex = 0;
+			activeWorkers = (uint32_t)workers.size();
+			generation++;
+		}
+		wake.notify_all();
+
+		RunIndices();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return activeWorkers == 0; });
+		job = nullptr;
+	}
+
+	//One worker per remaining hardware thread
+	static uint32_t DefaultThreadCount() {
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	inline uint32_t GetThreadCount() const { return (uint32_t)workers.size() + 1; }
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isStopping = true;
+		}
+		wake.notify_all();
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include "GraphicsRender.h"
+#include "TileRegistry.h"
+
+//One quad per tile in a single vertex array, so the whole level is one draw call.
+//Only the tiles of a dirty region are rewritten when the level changes.
+class TileMesh {
+private:
+	sf::VertexArray quads;
+	const sf::Texture* texture;
+	uint32_t width, height;
+	float tileSize;
+
+	void Rebuild(const Level& level) {
+		width = level.GetWidth();
+		height = level.GetHeight();
+		quads.resize((std::size_t)width * height * 4);
+
+		for (uint32_t i = 0; i < height; i++) {
+			for (uint32_t j = 0; j < width; j++) {
+				sf::Vertex* quad = &quads[((std::size_t)i * width + j) * 4];
+				float x = j * tileSize, y = i * tileSize;
+
+				quad[0].position = { x, y };
+				quad[1].position = { x + tileSize, y };
+				quad[2].position = { x + tileSize, y + tileSize };
+				quad[3].position = { x, y + tileSize };
+			}
+		}
+
+		UpdateTiles(level, LevelRegion(0, 0, width, height));
+	}
+
+	void UpdateTiles(const Level& level, const LevelRegion& region) {
+		const TileRegistry& tiles = TileRegistry::Get();
+
+		for (uint32_t i = region.top; i < region.bottom; i++) {
+			for (uint32_t j = region.left; j < region.right; j++) {
+				char c = level.GetCharacter(j, i);
+				const sf::Color& color = tiles.GetColor(c);
+				const sf::IntRect& rect = tiles.GetTextureRect(c);
+				sf::Vertex* quad = &quads[((std::size_t)i * width + j) * 4];
+
+				float left = (float)rect.left, top = (float)rect.top;
+				float right = left + rect.width, bottom = top + rect.height;
+
+				quad[0].color = quad[1].color = quad[2].color = quad[3].color = color;
+				quad[0].texCoords = { left, top };
+				quad[1].texCoords = { right, top };
+				quad[2].texCoords = { right, bottom };
+				quad[3].texCoords = { left, bottom };
+			}
+		}
+	}
+public:
+	TileMesh() {
+		quads.setPrimitiveType(sf::Quads);
+		texture = nullptr;
+		width = height = 0;
+		tileSize = 32.0f;
+	}
+
+	void SetTileSize(float size) {
+		tileSize = size;
+		width = height = 0;
+	}
+
+	//Texture the registry's texture rects refer to, or nullptr for flat colors
+	void SetTexture(const sf::Texture* tileTexture) { texture = tileTexture; }
+
+	void Update(const Level& level, const LevelRegion& dirty) {
+		if (level.GetWidth() != width || level.GetHeight() != height) {
+			Rebuild(level);
+			return;
+		}
+
+		if (!dirty.IsEmpty()) {
+			UpdateTiles(level, LevelRegion(dirty.left, dirty.top, std::min(dirty.right, width), std::min(dirty.bottom, height)));
+		}
+	}
+
+	void Render(sf::RenderWindow& window) const {
+		window.draw(quads, texture);
+	}
+};
+
+//One flat-colored quad per run of equal tiles, for levels too large to keep a quad per tile.
+//Works with any level type that has ForEachSpan, such as Level or SparseLevel.
+template<typename LevelType>
+void AppendSpanQuads(const LevelType& level, const LevelRegion& region, float tileSize, std::vector<sf::Vertex>& vertices) {
+	const TileRegistry& tiles = TileRegistry::Get();
+
+	level.ForEachSpan(region, [&](uint32_t y, uint32_t x1, uint32_t x2, char c) {
+		if (!(tiles.GetFlags(c) & TileVisible)) return;
+
+		const sf::Color& color = tiles.GetColor(c);
+		float left = x1 * tileSize, right = x2 * tileSize;
+		float top = y * tileSize, bottom = top + tileSize;
+
+		vertices.emplace_back(sf::Vector2f(left, top), color);
+		vertices.emplace_back(sf::Vector2f(right, top), color);
+		vertices.emplace_back(sf::Vector2f(right, bottom), color);
+		vertices.emplace_back(sf::Vector2f(left, bottom), color);
+	});
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <cstdint>
+
+enum TileFlags : uint8_t {
+	TileSolid = 1 << 0,
+	TileOneWay = 1 << 1,  //Solid only to things falling onto it from above
+	TileHazard = 1 << 2,
+	TileVisible = 1 << 3
+};
+
+//Attributes of every tile character, kept as flat tables indexed by the character so
+//collision and rendering are plain lookups instead of switches
+class TileRegistry {
+private:
+	uint8_t flags[256];
+	sf::Color colors[256];
+	sf::IntRect textureRects[256];
+
+	TileRegistry() {
+		for (int i = 0; i < 256; i++) {
+			flags[i] = 0;
+			colors[i] = sf::Color::Transparent;
+		}
+
+		Register('#', TileSolid | TileVisible, sf::Color::Yellow);
+		Register('=', TileOneWay | TileVisible, sf::Color(255, 160, 0));
+		Register('^', TileHazard | TileVisible, sf::Color::Red);
+	}
+public:
+	static TileRegistry& Get() {
+		static TileRegistry registry;
+		return registry;
+	}
+
+	void Register(char c, uint8_t tileFlags, sf::Color color, sf::IntRect textureRect = sf::IntRect()) {
+		flags[(unsigned char)c] = tileFlags;
+		colors[(unsigned char)c] = (tileFlags & TileVisible) ? color : sf::Color::Transparent;
+		textureRects[(unsigned char)c] = textureRect;
+	}
+
+	inline uint8_t GetFlags(char c) const { return flags[(unsigned char)c]; }
+	inline const sf::Color& GetColor(char c) const { return colors[(unsigned char)c]; }
+	inline const sf::IntRect& GetTextureRect(char c) const { return textureRects[(unsigned char)c]; }
+};
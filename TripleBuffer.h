@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+//Lock-free hand-off of the latest value from one producer thread to one consumer thread.
+//The producer always has a buffer to write into and the consumer always holds the most
+//recent complete one; values the consumer did not get to in time are skipped.
+template<typename T>
+class TripleBuffer {
+private:
+	T buffers[3];
+
+	//Index of the buffer in the middle, plus a flag telling that it holds unread data
+	std::atomic<uint8_t> middle;
+	uint8_t writeIndex, readIndex;
+
+	static constexpr uint8_t freshBit = 4;
+public:
+	TripleBuffer() {
+		writeIndex = 0;
+		middle = 1;
+		readIndex = 2;
+	}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	//Producer side
+	T& GetWriteBuffer() { return buffers[writeIndex]; }
+
+	void Publish() {
+		uint8_t previous = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel);
+		writeIndex = previous & ~freshBit;
+	}
+
+	//Consumer side. Returns true if a newer value than the last one has been taken.
+	bool Acquire() {
+		if (!(middle.load(std::memory_order_relaxed) & freshBit)) return false;
+
+		uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+		readIndex = previous & ~freshBit;
+		return true;
+	}
+
+	const T& GetReadBuffer() const { return buffers[readIndex]; }
+};
@@ -0,0 +1,197 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include "SaveState.h"
+
+//Chain of Verlet particles held together by distance constraints.
+//Particle state is stored as separate arrays (SoA) and every solver loop is
+//branch-free over contiguous floats so the compiler can vectorize it.
+class VerletRope {
+private:
+	std::vector<float> x, y, prevX, prevY;
+	std::vector<float> invMass; //1 for free particles, 0 for pinned ones
+
+	//Per-segment corrections, padded with a zero entry at both ends so that particle i
+	//reads segment i - 1 (to its left) at i and segment i (to its right) at i + 1
+	std::vector<float> segX, segY;
+	//Constraint weights of one colour, zero for the segments of the other one
+	std::vector<float> segWeightEven, segWeightOdd;
+
+	float segmentLength, stiffness, damping;
+	int iterations;
+
+	void Integrate(float gx, float gy) {
+		std::size_t n = x.size();
+		float* px = x.data(); float* py = y.data();
+		float* ox = prevX.data(); float* oy = prevY.data();
+		const float* w = invMass.data();
+
+		for (std::size_t i = 0; i < n; i++) {
+			float vx = (px[i] - ox[i]) * damping + gx;
+			float vy = (py[i] - oy[i]) * damping + gy;
+			ox[i] = px[i];
+			oy[i] = py[i];
+			px[i] += vx * w[i];
+			py[i] += vy * w[i];
+		}
+	}
+
+	void SolvePass(const float* sw) {
+		std::size_t nSegments = x.size() - 1;
+		float* px = x.data(); float* py = y.data();
+		float* sx = segX.data() + 1; float* sy = segY.data() + 1;
+		const float* w = invMass.data();
+
+		for (std::size_t s = 0; s < nSegments; s++) {
+			float dx = px[s + 1] - px[s];
+			float dy = py[s + 1] - py[s];
+			float d = std::sqrt(dx * dx + dy * dy + 1e-6f);
+			float c = (d - segmentLength) / d * sw[s];
+			sx[s] = dx * c;
+			sy[s] = dy * c;
+		}
+
+		//Each particle takes the corrections of the segments on both of its sides
+		std::size_t n = x.size();
+		sx = segX.data(); sy = segY.data();
+		for (std::size_t i = 0; i < n; i++) {
+			px[i] += w[i] * (sx[i + 1] - sx[i]);
+			py[i] += w[i] * (sy[i + 1] - sy[i]);
+		}
+	}
+
+	void ComputeSegmentWeights() {
+		std::size_t nSegments = x.size() - 1;
+		segWeightEven.assign(nSegments, 0.0f);
+		segWeightOdd.assign(nSegments, 0.0f);
+
+		for (std::size_t s = 0; s < nSegments; s++) {
+			float wSum = invMass[s] + invMass[s + 1];
+			float weight = wSum > 0.0f ? stiffness / wSum : 0.0f;
+			(s % 2 == 0 ? segWeightEven : segWeightOdd)[s] = weight;
+		}
+	}
+public:
+	VerletRope() {
+		segmentLength = 16.0f;
+		stiffness = 1.0f;
+		damping = 0.98f;
+		iterations = 16;
+	}
+
+	//Builds a straight rope between two pinned anchors
+	void Build(float x1, float y1, float x2, float y2, float approxSegmentLength = 16.0f) {
+		float dx = x2 - x1, dy = y2 - y1;
+		float length = std::sqrt(dx * dx + dy * dy);
+
+		std::size_t nSegments = (std::size_t)std::fmax(1.0f, std::round(length / approxSegmentLength));
+		std::size_t n = nSegments + 1;
+		segmentLength = length / (float)nSegments;
+
+		x.resize(n); y.resize(n);
+		invMass.assign(n, 1.0f);
+		invMass.front() = invMass.back() = 0.0f;
+
+		for (std::size_t i = 0; i < n; i++) {
+			float t = (float)i / (float)nSegments;
+			x[i] = x1 + dx * t;
+			y[i] = y1 + dy * t;
+		}
+		prevX = x;
+		prevY = y;
+
+		segX.assign(nSegments + 2, 0.0f);
+		segY.assign(nSegments + 2, 0.0f);
+		ComputeSegmentWeights();
+	}
+
+	void Step(float gx, float gy) {
+		if (x.size() < 2) return;
+		Integrate(gx, gy);
+		SolveConstraints();
+	}
+
+	//Pulls the particles back to their segment lengths without integrating, to settle positions
+	//moved by hand after Step. The previous positions are left alone, so the move still shows up
+	//as velocity on the next Step.
+	void SolveConstraints() {
+		if (x.size() < 2) return;
+
+		for (int k = 0; k < iterations; k++) {
+			//Red-black ordering: within one pass no two segments share a particle,
+			//so each pass is a plain data-parallel loop but converges like Gauss-Seidel
+			SolvePass(segWeightEven.data());
+			SolvePass(segWeightOdd.data());
+		}
+	}
+
+	//Moves every free particle that lies horizontally inside [left, right] and vertically
+	//inside [top, bottom] down to targetY. Returns the number of particles touched.
+	int PushDown(float left, float right, float top, float bottom, float targetY) {
+		std::size_t n = x.size();
+		int count = 0;
+
+		for (std::size_t i = 0; i < n; i++) {
+			bool inside = invMass[i] > 0.0f && x[i] >= left && x[i] <= right && y[i] >= top && y[i] <= bottom;
+			y[i] = inside ? targetY : y[i];
+			count += inside;
+		}
+
+		return count;
+	}
+
+	//Mean height of the free particles inside [left, right], or fallback if there are none
+	float GetSurfaceY(float left, float right, float fallback) const {
+		std::size_t n = x.size();
+		float sum = 0.0f;
+		int count = 0;
+
+		for (std::size_t i = 0; i < n; i++) {
+			bool inside = invMass[i] > 0.0f && x[i] >= left && x[i] <= right;
+			sum += inside ? y[i] : 0.0f;
+			count += inside;
+		}
+
+		return count > 0 ? sum / count : fallback;
+	}
+
+	void GetExtents(float& left, float& top, float& right, float& bottom) const {
+		left = top = 1e30f;
+		right = bottom = -1e30f;
+
+		for (std::size_t i = 0; i < x.size(); i++) {
+			left = std::fmin(left, x[i]);
+			right = std::fmax(right, x[i]);
+			top = std::fmin(top, y[i]);
+			bottom = std::fmax(bottom, y[i]);
+		}
+	}
+
+	//Particle positions only; the rope must be built with the same shape before loading
+	void SaveState(StateWriter& out) const {
+		out.WriteArray(x);
+		out.WriteArray(y);
+		out.WriteArray(prevX);
+		out.WriteArray(prevY);
+	}
+
+	bool LoadState(StateReader& in) {
+		std::size_t n = x.size();
+		bool isRead = in.ReadArray(x) && in.ReadArray(y) && in.ReadArray(prevX) && in.ReadArray(prevY);
+		return isRead && x.size() == n && y.size() == n && prevX.size() == n && prevY.size() == n;
+	}
+
+	void SetStiffness(float value) {
+		stiffness = value;
+		if (x.size() > 1) ComputeSegmentWeights();
+	}
+	void SetIterations(int value) { iterations = value; }
+	void SetDamping(float value) { damping = value; }
+
+	inline std::size_t GetParticleCount() const { return x.size(); }
+	inline float GetX(std::size_t i) const { return x[i]; }
+	inline float GetY(std::size_t i) const { return y[i]; }
+	inline const float* GetXData() const { return x.data(); }
+	inline const float* GetYData() const { return y.data(); }
+};
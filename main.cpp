@@ -1,32 +1,63 @@
 #include <SFML/Graphics.hpp>
 #include "GraphicsRender.h"
+#include "VerletRope.h"
+#include "TileRegistry.h"
+#include "TileMesh.h"
+#include "OverlayCache.h"
+#include "LevelOverview.h"
+#include "SparseLevel.h"
+#include "NavGraph.h"
+#include "LevelQuery.h"
+#include "RopeIslands.h"
+#include "RopeContact.h"
+#include "HandlePool.h"
+#include "InputMap.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
+#include "ThreadPool.h"
+#include "LatencyTracker.h"
+#include "AudioManager.h"
+#include "FileWatcher.h"
+#include "SceneGenerator.h"
+#include "SaveState.h"
+#include "FrameArena.h"
+#include "SelfCheck.h"
+#include <memory>
+#include <variant>
+#include <thread>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+//Replaced only to count heap allocations for FrameArena's per-frame figure
+void* operator new(std::size_t size) {
+	heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* memory = std::malloc(size ? size : 1)) return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
 
 class Player {
 private:
-	sf::Vector2f position, velocity;
+	sf::Vector2f position, velocity, spawnPosition;
 	sf::RectangleShape box;
 	float size;
 	float gSpeed, gMax, jumpSpeed, moveSpeed;
 
 	bool isContact;
 
-	bool TileMapCollision(const Level& level) {
-		int tileLeft = (int)(position.x / size);
-		int tileRight = (int)ceilf((position.x + size) / size);
-		int tileTop = (int)(position.y / size);
-		int tileBottom = (int)ceilf((position.y + size) / size);
-	
-		for (int i = tileTop; i < tileBottom; i++) {
-			for (int j = tileLeft; j < tileRight; j++) {
-				switch (level.GetCharacter(j, i)) {
-				case '#':
-					return true;
-					break;
-				}
-			}
-		}
-
-		return false;
+	//Flags of every tile the player overlaps. One-way tiles only count on rows
+	//whose top is at or below oneWayAbove.
+	template<typename LevelType>
+	uint8_t TileMapCollision(const LevelType& level, float oneWayAbove) const {
+		return LevelQuery<LevelType>(level, size).OverlapBody(GetBounds(), oneWayAbove);
 	}
 public:
 	Player() {
@@ -43,13 +74,15 @@ public:
 		moveSpeed = 4.0f;
 	}
 
-	void Logic(const Level& level) {
+	template<typename LevelType>
+	void Logic(const LevelType& level) {
+		const float never = 1e30f;
 		sf::Vector2f initPosition;
 
 		initPosition.x = position.x;
 		position.x += velocity.x;
-		bool isCollideX = TileMapCollision(level);
-		if (isCollideX) {
+		uint8_t flagsX = TileMapCollision(level, never);
+		if (flagsX & TileSolid) {
 			position.x = initPosition.x;
 		}
 
@@ -62,22 +95,32 @@ public:
 		isContact = false;
 
 		position.y += velocity.y;
-		bool isCollideY = TileMapCollision(level);
-		if (isCollideY) {
+		uint8_t flagsY = TileMapCollision(level, velocity.y > 0.0f ? initPosition.y + size : never);
+		if (flagsY & (TileSolid | TileOneWay)) {
 			position.y = initPosition.y;
 			position.y -= ((int)initPosition.y % (int)size);
 			if (velocity.y > 0.0f) isContact = true;
 		}
+
+		if ((flagsX | flagsY) & TileHazard) {
+			position = spawnPosition;
+			velocity.y = 0.0f;
+		}
 	
 		box.setPosition(position);
 	}
 
-	void Render(sf::RenderWindow& window) {
-		window.draw(box);
-	}
+	inline const sf::RectangleShape& GetShape() const { return box; }
 
 	inline sf::Vector2f GetPosition() const { return position; }
 	void SetPosition(const sf::Vector2f& pos) { position = pos; }
+	void SetSpawnPosition(const sf::Vector2f& pos) { spawnPosition = pos; }
+
+	inline sf::Vector2f GetVelocity() const { return velocity; }
+
+	inline sf::FloatRect GetBounds() const { return { position, { size, size } }; }
+	//Thin band around the soles of the player that rests on ropes
+	inline sf::FloatRect GetFeetBounds() const { return { position.x, position.y + size - 3.0f, size, 6.0f }; }
 
 	void SetVelocity(int component, float value) {
 		switch (component) {
@@ -98,20 +141,60 @@ public:
 		velocity.x = dir * moveSpeed;
 	}
 
+	NavParams GetNavParams() const {
+		NavParams params;
+		params.size = size;
+		params.gSpeed = gSpeed;
+		params.gMax = gMax;
+		params.jumpSpeed = jumpSpeed;
+		params.moveSpeed = moveSpeed;
+		return params;
+	}
+
 	bool& GetIsContact() { return isContact; }
+
+	void SaveState(StateWriter& out) const {
+		out.Write(position);
+		out.Write(velocity);
+		out.Write(spawnPosition);
+		out.Write(isContact);
+	}
+
+	bool LoadState(StateReader& in) {
+		bool isRead = in.Read(position) && in.Read(velocity) && in.Read(spawnPosition) && in.Read(isContact);
+		box.setPosition(position);
+		return isRead;
+	}
 };
 
+//Data and behaviour shared by every rope kind. There is no virtual dispatch: each kind is a
+//concrete type and StringRopeVariant forwards calls to whichever one it holds.
 class StringRopeMain {
 public:
 	sf::Vector2f position, points[4];
 	float stringLength, elasticMax, stringStretch;
 	bool isPlayerOnString;
 
+	//Things that happened to the rope since the sounds were last played, set by its own Logic
+	enum SoundEvent : uint8_t {
+		SoundLanded = 1 << 0,
+		SoundStretched = 1 << 1,
+		SoundLaunched = 1 << 2,
+		SoundSnapped = 1 << 3
+	};
+	uint8_t soundEvents;
+
 	sf::Color color;
 
+	//Same order as the alternatives of StringRopeVariant
 	enum StringType {
 		StringRope = 0,
-		StringBounce = 1
+		StringBounce = 1,
+		StringVerlet = 2,
+		StringSticky = 3,
+		StringOneWay = 4,
+		StringBreakable = 5,
+		StringTypeCount
 	};
 
 	StringRopeMain() {
@@ -119,126 +202,488 @@ public:
 		elasticMax = 32.0f;
 		stringStretch = 0.0f;
 		isPlayerOnString = false;
+		soundEvents = 0;
 	}
 
-	virtual void Logic(Player&) = 0;
-	
-	bool IsPositionInBounds(const sf::Vector2f& position) {
-		auto [x, y] = position;
-		return (y + 35.0f > points[1].y && y + 29.0f < points[1].y && x + 32 > position.x && x < position.x + stringLength);
+	uint8_t TakeSoundEvents() {
+		uint8_t events = soundEvents;
+		soundEvents = 0;
+		return events;
+	}
+
+	//Narrow phase against the rope's actual segments
+	RopeContact FindContact(const sf::FloatRect& box) const {
+		float xs[4], ys[4], scratch[3];
+		GetPolyline(xs, ys);
+		return FindPolylineContact(xs, ys, 4, box, scratch);
 	}
 
-	void Render(sf::RenderWindow& window) {
-		DrawLine(window, points[0].x, points[0].y, points[1].x, points[1].y, color);
-		DrawLine(window, points[1].x, points[1].y, points[2].x, points[2].y, color);
-		DrawLine(window, points[2].x, points[2].y, points[3].x, points[3].y, color);
+	void AddToBatch(SegmentBatch& batch) const {
+		float xs[4], ys[4];
+		GetPolyline(xs, ys);
+		batch.AddPolyline(xs, ys, 4);
+	}
+
+	//Adds the rope's segments as pairs of vertices for an sf::Lines draw
+	void AppendLines(std::vector<sf::Vertex>& lines) const {
+		for (int i = 0; i < 3; i++) {
+			lines.emplace_back(points[i], color);
+			lines.emplace_back(points[i + 1], color);
+		}
 	}
 
 	inline sf::Vector2f GetPosition() const { return position; }
+
+	void GetPolyline(float* xs, float* ys) const {
+		for (int i = 0; i < 4; i++) {
+			xs[i] = points[i].x;
+			ys[i] = points[i].y;
+		}
+	}
+
+	//Area the rope can occupy this tick, used to find the agents it may touch. The middle
+	//points follow the player and can end up past the anchors.
+	sf::FloatRect GetBounds() const {
+		float left = position.x, right = position.x + stringLength;
+		for (auto& point : points) {
+			left = std::fminf(left, point.x);
+			right = std::fmaxf(right, point.x);
+		}
+		return { left, position.y, right - left, std::fmaxf(elasticMax, stringStretch) };
+	}
+
+	void SaveState(StateWriter& out) const {
+		out.Write(position);
+		out.Write(points);
+		out.Write(stringLength);
+		out.Write(elasticMax);
+		out.Write(stringStretch);
+		out.Write(isPlayerOnString);
+	}
+
+	bool LoadState(StateReader& in) {
+		return in.Read(position) && in.Read(points) && in.Read(stringLength) &&
+			in.Read(elasticMax) && in.Read(stringStretch) && in.Read(isPlayerOnString);
+	}
+
 	void SetStringLength(float length) { stringLength = length; }
 	void SetPosition(const sf::Vector2f& pos) { 
 		position = pos; 
 			
 		points[0] = position;
 		points[3] = { position.x + stringLength, position.y };
-		points[1] = { points[3].x / 2.0f, position.y };
+		points[1] = { position.x + stringLength / 2.0f, position.y };
 		points[2] = { points[1].x + 32.0f, position.y };
 	}
 };
 
-class StringRope : public StringRopeMain {
+//Policies of the elastic rope kinds. A new kind is a new policy plus an entry in
+//StringRopeVariant; every field is read at compile time.
+struct StringRopePolicy {
+	static constexpr float elasticMax = 32.0f;
+	static constexpr float stretchRate = 2.0f;
+	static constexpr float relaxRate = 1.0f;
+	static constexpr float launchSpeed = 0.0f;  //Speed the player is thrown at when fully stretched, 0 for none
+	static constexpr float grip = 0.0f;         //Fraction of the player's horizontal motion the rope holds back
+	static constexpr bool isOneWay = false;     //Only catches a player that is falling
+	static constexpr int breakTicks = 0;        //Ticks of load before the rope snaps, 0 for never
+	static constexpr uint32_t color = 0xFFFFFFFF;
+};
+
+struct StringBouncePolicy : StringRopePolicy {
+	static constexpr float elasticMax = 60.0f;
+	static constexpr float relaxRate = 4.0f;
+	static constexpr float launchSpeed = 40.0f;
+	static constexpr uint32_t color = 0xFF00FFFF;
+};
+
+struct StringStickyPolicy : StringRopePolicy {
+	static constexpr float grip = 0.75f;
+	static constexpr uint32_t color = 0x00FF00FF;
+};
+
+struct StringOneWayPolicy : StringRopePolicy {
+	static constexpr bool isOneWay = true;
+	static constexpr uint32_t color = 0x8080FFFF;
+};
+
+struct StringBreakablePolicy : StringRopePolicy {
+	static constexpr int breakTicks = 90;
+	static constexpr uint32_t color = 0xFF8000FF;
+};
+
+template<typename Policy>
+class ElasticString : public StringRopeMain {
+private:
+	bool isElasticMaxPoint, isBroken;
+	int loadTicks;
 public:
-	StringRope() {
-		color = sf::Color::White;
+	ElasticString() {
+		color = sf::Color(Policy::color);
+		elasticMax = Policy::elasticMax;
+
+		isElasticMaxPoint = false;
+		isBroken = false;
+		loadTicks = 0;
 	}
 
-	void Logic(Player& player) override {
-		auto [x, y] = player.GetPosition();
+	void Logic(Player& player, const RopeContact& contact) {
+		bool isTouching = contact.isHit;
+		if constexpr (Policy::isOneWay) isTouching = isTouching && player.GetVelocity().y >= 0.0f;
+		if constexpr (Policy::breakTicks > 0) isTouching = isTouching && !isBroken;
 
-		if (y + 35.0f > points[1].y && y + 29.0f < points[1].y && x + 32 > position.x && x < position.x + stringLength) {
+		if (isTouching) {
+			auto [x, y] = player.GetPosition();
 
+			if (!isPlayerOnString) soundEvents |= SoundLanded;
+			soundEvents |= SoundStretched;
 			isPlayerOnString = true;
 
-			float distance = x - position.x;
+			float distance = x - points[0].x;
 			points[1].x = points[0].x + distance;
 			points[2].x = points[1].x + 32.0f;
 
-			stringStretch += 2.0f;
-			stringStretch = std::fminf(stringStretch, elasticMax);
-			player.SetVelocity(1, -1.0f * std::fminf(2.0f, stringStretch));
+			if constexpr (Policy::launchSpeed > 0.0f) {
+				if (!isElasticMaxPoint) {
+					stringStretch += Policy::stretchRate;
+					stringStretch = std::fminf(stringStretch, elasticMax);
+					player.SetVelocity(1, -1.0f * std::fminf(2.0f, stringStretch));
+				}
+				else {
+					player.SetVelocity(1, -Policy::launchSpeed);
+					isElasticMaxPoint = false;
+					soundEvents |= SoundLaunched;
+				}
+
+				if (stringStretch >= elasticMax) {
+					isElasticMaxPoint = true;
+				}
+			}
+			else {
+				stringStretch += Policy::stretchRate;
+				stringStretch = std::fminf(stringStretch, elasticMax);
+				player.SetVelocity(1, -1.0f * std::fminf(2.0f, stringStretch));
+			}
+
+			if constexpr (Policy::grip > 0.0f) {
+				player.SetPosition({ x - player.GetVelocity().x * Policy::grip, y });
+			}
+
+			if constexpr (Policy::breakTicks > 0) {
+				if (++loadTicks >= Policy::breakTicks) {
+					isBroken = true;
+					soundEvents |= SoundSnapped;
+				}
+			}
 
 			points[1].y = points[0].y + stringStretch;
 			points[2].y = points[0].y + stringStretch;
 		}
 		else {
-			isPlayerOnString = false;
-			if (stringStretch > 0.0f) {
-				stringStretch--;
-				points[1].y = points[0].y + stringStretch;
-				points[2].y = points[0].y + stringStretch;
+			Relax();
+		}
+	}
+
+	//The tick of a rope nobody stands on
+	void Relax() {
+		isPlayerOnString = false;
+		isElasticMaxPoint = false;
+		if (stringStretch > 0.0f) {
+			stringStretch = std::fmaxf(0.0f, stringStretch - Policy::relaxRate);
+			points[1].y = points[0].y + stringStretch;
+			points[2].y = points[0].y + stringStretch;
+		}
+	}
+
+	void SaveState(StateWriter& out) const {
+		StringRopeMain::SaveState(out);
+		out.Write(isElasticMaxPoint);
+		out.Write(isBroken);
+		out.Write(loadTicks);
+	}
+
+	bool LoadState(StateReader& in) {
+		return StringRopeMain::LoadState(in) && in.Read(isElasticMaxPoint) && in.Read(isBroken) && in.Read(loadTicks);
+	}
+
+	void AppendLines(std::vector<sf::Vertex>& lines) const {
+		if constexpr (Policy::breakTicks > 0) {
+			if (isBroken) {
+				//Two loose ends hanging from the anchors
+				lines.emplace_back(points[0], color);
+				lines.emplace_back(points[0] + sf::Vector2f(0.0f, 16.0f), color);
+				lines.emplace_back(points[3], color);
+				lines.emplace_back(points[3] + sf::Vector2f(0.0f, 16.0f), color);
+				return;
 			}
 		}
+
+		StringRopeMain::AppendLines(lines);
 	}
 };
 
-class StringBounce : public StringRopeMain {
+class StringVerlet : public StringRopeMain {
 private:
-	bool isElasticMaxPoint;
-	float jumpSpeed;
+	VerletRope rope;
+	mutable std::vector<float> scratch;
+	float gravity, playerWeight;
 public:
-	StringBounce() {
-		isElasticMaxPoint = false;
-		color = sf::Color::Magenta;
-		elasticMax = 60.0f;
-	
-		jumpSpeed = 40.0f;
+	StringVerlet() {
+		color = sf::Color::Cyan;
+		elasticMax = 48.0f;
+
+		gravity = 0.1f;
+		playerWeight = 1.0f;
 	}
 
-	void Logic(Player& player) override {
-		auto [x, y] = player.GetPosition();
-	
-		if (y + 35.0f > points[1].y && y + 29.0f < points[1].y && x + 32 > position.x && x < position.x + stringLength) {
-		
-			isPlayerOnString = true;
+	void SetPosition(const sf::Vector2f& pos) {
+		StringRopeMain::SetPosition(pos);
+		rope.Build(position.x, position.y, position.x + stringLength, position.y);
+	}
 
-			float distance = x - points[0].x;
+	inline std::size_t GetParticleCount() const { return rope.GetParticleCount(); }
 
-			points[1].x = points[0].x + distance;
-			points[2].x = points[1].x + 32.0f;
+	void Logic(Player& player, const RopeContact& contact) {
+		rope.Step(0.0f, gravity);
+		bool wasPlayerOnString = isPlayerOnString;
+		isPlayerOnString = false;
 
-			if (!isElasticMaxPoint) {
-				stringStretch += 2.0f;
-				stringStretch = std::fminf(stringStretch, elasticMax);
-				player.SetVelocity(1, -1.0f * std::fminf(2.0f, stringStretch));
-			}
-			else {
-				player.SetVelocity(1, -jumpSpeed);
-				isElasticMaxPoint = false;
+		if (contact.isHit) {
+			auto [x, y] = player.GetPosition();
+			float size = 32.0f;
+			float feet = y + size;
+
+			//The player's weight drags the particles under its feet down, capped by the rope's elasticity
+			float target = std::fminf(feet + playerWeight, position.y + elasticMax);
+			int contacts = rope.PushDown(x, x + size, y + size / 2.0f, feet + 5.0f, target);
+
+			isPlayerOnString = contacts > 0;
+			if (isPlayerOnString) {
+				soundEvents |= wasPlayerOnString ? SoundStretched : SoundLanded | SoundStretched;
+				rope.SolveConstraints();
+
+				//Ride on whatever height the constraints settled the rope at
+				float surface = rope.GetSurfaceY(x, x + size, feet);
+				player.SetPosition({ x, surface - size });
+				player.SetVelocity(1, 0.0f);
+				player.GetIsContact() = true;
 			}
+		}
 
-			if (stringStretch >= elasticMax) {
-				isElasticMaxPoint = true;
-			}
-		
-			points[1].y = points[0].y + stringStretch;
-			points[2].y = points[0].y + stringStretch;
+		UpdateStretch();
+	}
+
+	void Relax() {
+		rope.Step(0.0f, gravity);
+		isPlayerOnString = false;
+		UpdateStretch();
+	}
+
+	void UpdateStretch() {
+		sf::FloatRect bounds = GetBounds();
+		stringStretch = std::fmaxf(0.0f, bounds.top + bounds.height - position.y);
+	}
+
+	void SaveState(StateWriter& out) const {
+		StringRopeMain::SaveState(out);
+		rope.SaveState(out);
+	}
+
+	bool LoadState(StateReader& in) {
+		if (!StringRopeMain::LoadState(in)) return false;
+
+		rope.Build(position.x, position.y, position.x + stringLength, position.y);
+		return rope.LoadState(in);
+	}
+
+	RopeContact FindContact(const sf::FloatRect& box) const {
+		scratch.resize(rope.GetParticleCount());
+		return FindPolylineContact(rope.GetXData(), rope.GetYData(), rope.GetParticleCount(), box, scratch.data());
+	}
+
+	void AddToBatch(SegmentBatch& batch) const {
+		batch.AddPolyline(rope.GetXData(), rope.GetYData(), rope.GetParticleCount());
+	}
+
+	sf::FloatRect GetBounds() const {
+		float left, top, right, bottom;
+		rope.GetExtents(left, top, right, bottom);
+		return { left, top, right - left, bottom - top };
+	}
+
+	void AppendLines(std::vector<sf::Vertex>& lines) const {
+		for (std::size_t i = 1; i < rope.GetParticleCount(); i++) {
+			lines.emplace_back(sf::Vector2f(rope.GetX(i - 1), rope.GetY(i - 1)), color);
+			lines.emplace_back(sf::Vector2f(rope.GetX(i), rope.GetY(i)), color);
 		}
-		else {
-			isPlayerOnString = false;
-			isElasticMaxPoint = false;
-			if (stringStretch > 0.0f) {
-				stringStretch -= 4.0f;
-				points[1].y = points[0].y + stringStretch;
-				points[2].y = points[0].y + stringStretch;
-			}
+	}
+};
+
+//Holds one rope of any kind by value. Each call is a std::visit, which compiles to a jump
+//on the kind followed by the kind's own, inlinable, member function.
+class StringRopeVariant {
+private:
+	std::variant<
+		ElasticString<StringRopePolicy>,
+		ElasticString<StringBouncePolicy>,
+		StringVerlet,
+		ElasticString<StringStickyPolicy>,
+		ElasticString<StringOneWayPolicy>,
+		ElasticString<StringBreakablePolicy>
+	> string;
+public:
+	template<typename String, typename = std::enable_if_t<!std::is_same_v<std::decay_t<String>, StringRopeVariant>>>
+	StringRopeVariant(String&& s)
+		: string(std::forward<String>(s)) {}
+
+	static StringRopeVariant Create(int type) {
+		switch (type) {
+		case StringRopeMain::StringBounce: return ElasticString<StringBouncePolicy>();
+		case StringRopeMain::StringVerlet: return StringVerlet();
+		case StringRopeMain::StringSticky: return ElasticString<StringStickyPolicy>();
+		case StringRopeMain::StringOneWay: return ElasticString<StringOneWayPolicy>();
+		case StringRopeMain::StringBreakable: return ElasticString<StringBreakablePolicy>();
 		}
+
+		return ElasticString<StringRopePolicy>();
+	}
+
+	void Logic(Player& player) {
+		std::visit([&](auto& s) { s.Logic(player, s.FindContact(player.GetFeetBounds())); }, string);
+	}
+
+	void Logic(Player& player, const RopeContact& contact) {
+		std::visit([&](auto& s) { s.Logic(player, contact); }, string);
+	}
+
+	//Same as Logic without a contact, for a rope no agent can reach
+	void Relax() {
+		std::visit([](auto& s) { s.Relax(); }, string);
+	}
+
+	RopeContact FindContact(const sf::FloatRect& box) const {
+		return std::visit([&](const auto& s) { return s.FindContact(box); }, string);
+	}
+
+	void AddToBatch(SegmentBatch& batch) const {
+		std::visit([&](const auto& s) { s.AddToBatch(batch); }, string);
+	}
+
+	sf::FloatRect GetBounds() const {
+		return std::visit([](const auto& s) { return s.GetBounds(); }, string);
+	}
+
+	void AppendLines(std::vector<sf::Vertex>& lines) const {
+		std::visit([&](const auto& s) { s.AppendLines(lines); }, string);
+	}
+
+	void Place(const sf::Vector2f& pos, float length) {
+		std::visit([&](auto& s) {
+			s.SetStringLength(length);
+			s.SetPosition(pos);
+		}, string);
+	}
+
+	StringRopeMain& GetMain() { return std::visit([](auto& s) -> StringRopeMain& { return s; }, string); }
+	const StringRopeMain& GetMain() const { return std::visit([](const auto& s) -> const StringRopeMain& { return s; }, string); }
+
+	uint8_t TakeSoundEvents() { return GetMain().TakeSoundEvents(); }
+
+	inline int GetType() const { return (int)string.index(); }
+
+	//Particles the rope simulates, zero for the kinds with four fixed points
+	std::size_t GetParticleCount() const {
+		const StringVerlet* verlet = std::get_if<StringVerlet>(&string);
+		return verlet ? verlet->GetParticleCount() : 0;
+	}
+	inline bool IsPlayerOnString() const { return GetMain().isPlayerOnString; }
+
+	void SaveState(StateWriter& out) const {
+		out.Write((uint8_t)string.index());
+		std::visit([&](const auto& s) { s.SaveState(out); }, string);
+	}
+
+	//Loads in place when the saved rope is of the same kind
+	bool LoadState(StateReader& in) {
+		uint8_t type = 0;
+		if (!in.Read(type) || type >= StringRopeMain::StringTypeCount) return false;
+
+		if (type != GetType()) *this = Create(type);
+		return std::visit([&](auto& s) { return s.LoadState(in); }, string);
 	}
 };
 
-typedef std::vector<std::unique_ptr<StringRopeMain>> StringRopesVector;
+typedef HandlePool<StringRopeVariant> StringRopesVector;
+
+sf::Color GetStringColor(int index) {
+	switch (index) {
+	case StringRopeMain::StringBounce:
+		return sf::Color(StringBouncePolicy::color);
+	case StringRopeMain::StringVerlet:
+		return sf::Color::Cyan;
+	case StringRopeMain::StringSticky:
+		return sf::Color(StringStickyPolicy::color);
+	case StringRopeMain::StringOneWay:
+		return sf::Color(StringOneWayPolicy::color);
+	case StringRopeMain::StringBreakable:
+		return sf::Color(StringBreakablePolicy::color);
+	}
+
+	return sf::Color(StringRopePolicy::color);
+}
+
+//Movement of the player and the agents as the navigation graph plans it
+NavParams GetAgentNavParams() {
+	NavParams params = Player().GetNavParams();
+	params.bounceSpeed = StringBouncePolicy::launchSpeed;
+	params.stickyGrip = StringStickyPolicy::grip;
+	return params;
+}
+
+//How far a rope has to be from an agent to be sure not to touch it this tick, so it can run
+//on any thread. The agents have moved by the time the ropes run, and after that a rope only
+//moves an agent it carries: it holds back part of a step of walking, or sets the feet on its
+//own surface, no further than the tallest rope's sag. The feet band under the body comes on top.
+float GetIslandMargin() {
+	Player agent;
+	NavParams params = GetAgentNavParams();
+
+	float sag = 0.0f;
+	for (int type = 0; type < StringRopeMain::StringTypeCount; type++) {
+		sag = std::fmax(sag, StringRopeVariant::Create(type).GetMain().elasticMax);
+	}
+	return sag + agent.GetFeetBounds().height + params.moveSpeed * params.stickyGrip;
+}
+
+//A rope of the kind as the navigation graph sees it. Breakable ropes are left out: they snap
+//under an agent after a while and never come back, so no path can rely on them.
+bool GetNavRope(int type, const sf::Vector2f& position, float length, NavRope& rope) {
+	switch (type) {
+	case StringRopeMain::StringBreakable:
+		return false;
+	case StringRopeMain::StringBounce:
+		rope.kind = NavRopeKind::Bounce;
+		break;
+	case StringRopeMain::StringSticky:
+		rope.kind = NavRopeKind::Sticky;
+		break;
+	case StringRopeMain::StringOneWay:
+		rope.kind = NavRopeKind::OneWay;
+		break;
+	default:
+		//Plain and Verlet ropes both catch feet that meet them either way
+		rope.kind = NavRopeKind::Rope;
+		break;
+	}
+
+	rope.position = position;
+	rope.length = length;
+	return true;
+}
+
 class LineEditor {
 private:
-	sf::Vector2i initMousePos, currentMousePos, newMousePos;
+	sf::Vector2i initMousePos, newMousePos;
 	int size;
 
 	bool isPressed;
@@ -248,139 +693,633 @@ public:
 		isPressed = false;
 	}
 
-	void ManageEvent(StringRopesVector& strings, int index, sf::Event e) {
-		switch (e.type) {
-		case sf::Event::MouseButtonPressed:
-			switch (e.key.code) {
-			case sf::Mouse::Left:
-				initMousePos = { e.mouseButton.x, e.mouseButton.y };
-				isPressed = true;
-				break;
-			}
-			break;
-		case sf::Event::MouseButtonReleased:
-			switch (e.key.code) {
-			case sf::Mouse::Left:
-				newMousePos = { (int)(e.mouseButton.x / size) * size, (int)(initMousePos.y / size) * size };
-				
-				isPressed = false;
-
-				sf::Vector2i initPos = initMousePos;
-				initMousePos = { (int)(initPos.x / size) * size, (int)(initPos.y / size * size) };
-
-				switch (index) {
-				case StringRopeMain::StringRope:
-					strings.push_back(std::make_unique<StringRope>());
-					break;
-				case StringRopeMain::StringBounce:
-					strings.push_back(std::make_unique<StringBounce>());
-					break;
-				}
+	//Returns the handle of the rope placed by this event, if any. PlaceRope may be bound to
+	//a key, whose events carry no position, so those use mousePos instead.
+	Handle ManageEvent(StringRopesVector& strings, int index, const ActionMap& actions, sf::Event e, const sf::Vector2i& mousePos) {
+		Handle placed;
+		bool isMouseEvent = e.type == sf::Event::MouseButtonPressed || e.type == sf::Event::MouseButtonReleased;
+		sf::Vector2i pos = isMouseEvent ? sf::Vector2i(e.mouseButton.x, e.mouseButton.y) : mousePos;
 
-				strings.back()->SetStringLength(std::fabsf((float)(initMousePos.x - newMousePos.x)));
-				strings.back()->SetPosition((sf::Vector2f)initMousePos);
+		if (actions.IsEvent(Action::PlaceRope, e)) {
+			initMousePos = pos;
+			isPressed = true;
+		}
+		else if (actions.IsEvent(Action::PlaceRope, e, false) && isPressed) {
+			newMousePos = { (int)(pos.x / size) * size, (int)(initMousePos.y / size) * size };
+			
+			isPressed = false;
 
-				break;
-			}
-			break;
+			sf::Vector2i initPos = initMousePos;
+			initMousePos = { (int)(initPos.x / size) * size, (int)(initPos.y / size * size) };
+
+			placed = strings.Insert(StringRopeVariant::Create(index));
+			strings.Get(placed)->Place((sf::Vector2f)initMousePos, std::fabsf((float)(initMousePos.x - newMousePos.x)));
 		}
+
+		return placed;
 	}
 
-	void Render(sf::RenderWindow& window, int index) {
+	void Render(sf::RenderWindow& window, int index) const {
 		if (isPressed) {
-			currentMousePos = sf::Mouse::getPosition(window);
+			sf::Vector2i currentMousePos = sf::Mouse::getPosition(window);
 
 			auto [x1, y1] = (sf::Vector2f)initMousePos;
 			auto [x2, y2] = (sf::Vector2f)currentMousePos;
 
 			//For a straight horizontal line (Preview Render)
-			DrawLine(window, x1, y1, x2, y1, index == 0 ? sf::Color::White : sf::Color::Magenta);
+			DrawLine(window, x1, y1, x2, y1, GetStringColor(index));
 		}
 	}
 };
 
+//Level tiles changed by the simulation in one tick
+struct TilePatch {
+	uint64_t sequence;
+	uint32_t levelWidth, levelHeight;
+	LevelRegion region;
+	std::string tiles;
+};
+
+//Everything the renderer needs from one simulation tick
+struct GameSnapshot {
+	uint64_t sequence = 0;
+	LatencyClock::time_point inputTime;
+
+	sf::RectangleShape playerShape;
+	std::vector<sf::Vertex> agentQuads;
+	std::vector<sf::Vertex> stringLines;
+
+	LineEditor lineEditor;
+	int activeStringIndex = 0;
+	bool hasSelection = false;
+	sf::FloatRect selectionBounds;
+
+	//Patches the renderer has not acknowledged yet, oldest first
+	std::vector<TilePatch> tilePatches;
+
+	std::vector<sf::Vertex> navPathLines;
+};
+
 class Game {
 private:
 	sf::RenderWindow window;
 	sf::Vector2u windowSize;
 	
-	sf::RectangleShape pixel, activeString;
+	sf::RectangleShape activeString;
 	float pixelSize;
+	TileMesh tileMesh;
+	OverlayCache overlay;
+	std::atomic<bool> isOverlayVisible;
+	LevelOverview levelOverview;
+	std::atomic<bool> isOverviewVisible;  //Whole level zoomed out to fit the window; editing is off meanwhile
+	char paintTile;
+
+	enum class PaintTool {
+		Brush,
+		Rectangle,
+		Fill
+	} paintTool;
+	sf::Vector2i lastPaintCell, paintStartCell;  //Cell of the previous brush sample and of the press that started a rectangle
 
 	LineEditor lineEditor;
 	StringRopesVector strings;
 	int activeStringIndex;
 
-	bool isKeyPressed;
+	std::vector<Handle> placementHistory;
+	Handle selectedString;
+	sf::RectangleShape selectionBox;
+
+	ThreadPool threadPool;
+	RopeIslands islands;
+	std::vector<sf::FloatRect> ropeBounds, agentBounds;
+	std::vector<uint32_t> allAgents;
+	std::vector<SegmentBatch> islandBatches;
+	std::vector<std::vector<RopeContact>> islandContacts;
+	float islandMargin;
+	bool isParallelLogic;
+	bool wasPlayerGrounded;
+
+	ActionMap actions;
+	InputSnapshot input;
+	DeviceState devices;  //Pipelined mode's view of the devices, built from the queued events
 
 	Level level;
 
+	//Where agents can walk, jump and bounce to; kept in step with the level and ropes each tick
+	NavGraph<Level> navGraph;
+	bool areNavRopesDirty, isNavPathVisible;
+
 	Player player;
 
-	void Input() {
-		auto KeyPress = [](sf::Keyboard::Key key) {
-			return sf::Keyboard::isKeyPressed(key);
-		};
+	//Scripted agents of a generated scene, each stepping through its script in a loop
+	struct Agent {
+		Player player;
+		std::vector<AgentStep> script;
+		uint32_t step, tick;
+	};
+	std::vector<Agent> agents;
+
+	//A state is recorded every few ticks while playing; holding rewind steps back through them
+	StateRing rewindStates;
+	//What a state is read into before it is loaded for real, so a corrupt one never reaches the world
+	Level scratchLevel;
+	std::vector<StringRopeVariant> scratchStrings;  //One of each kind, indexed by StringType
+	Agent scratchAgent;
+	uint32_t ticksSinceRecord;
+	std::vector<uint8_t> quickSave;
+
+	GameSnapshot frameSnapshot;
+
+	//Pipelined mode: the simulation thread owns everything above, the render thread
+	//only sees published snapshots and its own copy of the level
+	TripleBuffer<GameSnapshot> snapshots;
+	std::atomic<uint64_t> acknowledgedSequence;
+	std::atomic<bool> isSimulating, isRendering;
+	uint64_t sequence, appliedSequence;
+	std::deque<TilePatch> pendingPatches;
+	Level renderLevel;
+
+	//Earliest input no acquired snapshot has carried yet, and the first snapshot that carried it
+	LatencyClock::time_point unshownInputTime;
+	uint64_t unshownInputSequence;
+
+	SpscQueue<TimedEvent, 1024> eventQueue;
+
+	LatencyTracker latency;
+	LatencyClock::time_point pendingInputTime;
+	std::atomic<bool> isVerticalSync;
+	bool isVerticalSyncApplied;
+
+	//Reloads are committed by the thread that owns what they change
+	enum ReloadChannel : uint32_t {
+		ReloadRender,
+		ReloadSimulation
+	};
 
-		auto MouseButton = [](sf::Mouse::Button button) {
-			return sf::Mouse::isButtonPressed(button);
-		};
+	//Last, so its thread stops before anything a reload refers to is destroyed
+	FileWatcher watcher;
+
+	//Pure function of the tick's input snapshot, no device is polled here
+	void Input(const InputSnapshot& input) {
+		if (!isOverviewVisible) Paint(input);
 
-		sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-		if (MouseButton(sf::Mouse::Right)) {
+		player.HorizontalMove((int)input.IsDown(Action::MoveRight) - (int)input.IsDown(Action::MoveLeft));
+
+		if (input.IsDown(Action::Jump)) {
+			TryJump(player);
+		}
+	}
 
-			auto [x, y] = sf::Vector2i(mousePos.x / pixelSize, mousePos.y / pixelSize);
+	void Paint(const InputSnapshot& input) {
+		sf::Vector2i cell((int)std::floor(input.mousePos.x / pixelSize), (int)std::floor(input.mousePos.y / pixelSize));
+		char c = input.IsDown(Action::Erase) ? '.' : paintTile;
 
-			char c = isKeyPressed ? '.' : '#';
-			level.SetCharacter((unsigned)x, (unsigned)y, c);
+		switch (paintTool) {
+		case PaintTool::Brush:
+			//Join consecutive samples so fast strokes leave no gaps
+			if (input.IsDown(Action::Paint)) {
+				sf::Vector2i from = input.WasPressed(Action::Paint) ? cell : lastPaintCell;
+				level.LineBrush(from.x, from.y, cell.x, cell.y, c);
+			}
+			break;
+		case PaintTool::Rectangle:
+			if (input.WasPressed(Action::Paint)) paintStartCell = cell;
+			if (input.WasReleased(Action::Paint)) {
+				level.FillRect(std::min(paintStartCell.x, cell.x), std::min(paintStartCell.y, cell.y),
+					std::max(paintStartCell.x, cell.x) + 1, std::max(paintStartCell.y, cell.y) + 1, c);
+			}
+			break;
+		case PaintTool::Fill:
+			if (input.WasPressed(Action::Paint) && cell.x >= 0 && cell.y >= 0) level.FloodFill((uint32_t)cell.x, (uint32_t)cell.y, c);
+			break;
 		}
+		lastPaintCell = cell;
+	}
 
-		player.HorizontalMove((int)(KeyPress(sf::Keyboard::D) - KeyPress(sf::Keyboard::A)));
+	//Agent 0 is the player, the scripted agents follow
+	inline Player& GetAgent(uint32_t index) { return index == 0 ? player : agents[index - 1].player; }
+	inline uint32_t GetAgentCount() const { return 1 + (uint32_t)agents.size(); }
+
+	void TryJump(Player& agent) {
+		bool isOnString = false;
 		for (auto& a : strings) {
-			if (KeyPress(sf::Keyboard::W) && a->isPlayerOnString) {
-				player.Jump();
+			//A rope may be carrying some other agent
+			isOnString = isOnString || (a.IsPlayerOnString() && (agents.empty() || a.FindContact(agent.GetFeetBounds()).isHit));
+		}
+
+		if (isOnString || agent.GetIsContact()) {
+			agent.GetIsContact() = false;
+			agent.Jump();
+		}
+	}
+
+	void AgentLogic() {
+		for (auto& agent : agents) {
+			const AgentStep& step = agent.script[agent.step];
+
+			agent.player.HorizontalMove(step.direction);
+			if (step.isJumping && agent.tick == 0) TryJump(agent.player);
+
+			if (++agent.tick >= step.ticks) {
+				agent.tick = 0;
+				agent.step = (agent.step + 1) % agent.script.size();
 			}
+
+			agent.player.Logic(level);
 		}
+	}
 
-		if (KeyPress(sf::Keyboard::W) && player.GetIsContact()) {
-			player.GetIsContact() = false;
-			player.Jump();
+	//The rope acts on the first of the agents standing on it, or relaxes if none is
+	void RopeAgentLogic(StringRopeVariant& rope, const uint32_t* agentIndices, std::size_t nAgents) {
+		for (std::size_t i = 0; i < nAgents; i++) {
+			Player& agent = GetAgent(agentIndices[i]);
+			RopeContact contact = rope.FindContact(agent.GetFeetBounds());
+			if (contact.isHit) {
+				rope.Logic(agent, contact);
+				return;
+			}
 		}
+
+		rope.Logic(GetAgent(agentIndices[0]), RopeContact());
 	}
 
 	void Logic() {
 		player.Logic(level);
+		bool isGrounded = player.GetIsContact();
+
+		AgentLogic();
+
+		if (!isParallelLogic) {
+			if (agents.empty()) {
+				for (auto& a : strings) {
+					a.Logic(player);
+				}
+			}
+			else {
+				allAgents.resize(GetAgentCount());
+				for (uint32_t i = 0; i < allAgents.size(); i++) allAgents[i] = i;
+
+				for (auto& a : strings) {
+					RopeAgentLogic(a, allAgents.data(), allAgents.size());
+				}
+			}
+		}
+		else {
+			ParallelStringLogic();
+		}
+
+		PlaySounds(isGrounded);
+	}
+
+	//Gathers the tick's sound events after the ropes are done, so the ropes never touch the audio
+	void PlaySounds(bool isGrounded) {
+		AudioManager& audio = AudioManager::Get();
+
+		if (isGrounded && !wasPlayerGrounded) audio.Play("land");
+		wasPlayerGrounded = isGrounded;
+
 		for (auto& a : strings) {
-			a->Logic(player);
+			uint8_t events = a.TakeSoundEvents();
+			if (!events) continue;
+
+			const StringRopeMain& string = a.GetMain();
+			float tension = string.elasticMax > 0.0f ? string.stringStretch / string.elasticMax : 0.0f;
+
+			if (events & StringRopeMain::SoundSnapped) audio.Play("snap");
+			if (events & StringRopeMain::SoundLaunched) audio.Play("bounce");
+			if (events & StringRopeMain::SoundLanded) audio.Play("twang", 0.8f + 0.4f * (float)a.GetType() / StringRopeMain::StringTypeCount);
+			if (events & StringRopeMain::SoundStretched) audio.Play("stretch", 1.0f + 0.5f * tension, 50.0f);
 		}
 	}
 
-	void Render() {
-		for (uint32_t i = 0; i < level.GetHeight(); i++) {
-			for (uint32_t j = 0; j < level.GetWidth(); j++) {
-				switch (level.GetCharacter(j, i)) {
-				case '#':
-					pixel.setFillColor(sf::Color::Yellow);
-					break;
-				case '.':
-					continue;
-					break;
-				}
-			
-				pixel.setPosition({ j * pixelSize, i * pixelSize });
-				window.draw(pixel);
+	void LoadSounds() {
+		struct SoundCue {
+			const char* name;
+			SoundPriority priority;
+			float minInterval;
+		};
+
+		//Stretch fires every tick a rope is loaded, the rate limit keeps it from using up the voices
+		const SoundCue cues[] = {
+			{ "land", SoundPriority::Normal, 0.05f },
+			{ "twang", SoundPriority::Normal, 0.05f },
+			{ "bounce", SoundPriority::High, 0.0f },
+			{ "snap", SoundPriority::High, 0.0f },
+			{ "stretch", SoundPriority::Low, 0.15f }
+		};
+
+		//The sounds are optional, a cue without its file is left out without a word
+		AssetHolder& assets = AssetHolder::Get();
+		for (auto& cue : cues) {
+			std::string filepath = std::string("Sounds/") + cue.name + ".wav";
+			if (!std::ifstream(filepath).good()) continue;
+
+			if (assets.AddSoundBuffer(cue.name, filepath)) {
+				AudioManager::Get().AddCue(cue.name, cue.name, cue.priority, cue.minInterval);
+			}
+		}
+	}
+
+	//Same result as the serial loop: ropes sharing an agent keep their order on one thread,
+	//ropes no agent can reach are spread over the pool in chunks
+	void ParallelStringLogic() {
+		const std::size_t freeChunkSize = 64;
+
+		ropeBounds.clear();
+		for (auto& a : strings) {
+			ropeBounds.push_back(a.GetBounds());
+		}
+		agentBounds.resize(GetAgentCount());
+		for (uint32_t i = 0; i < agentBounds.size(); i++) {
+			agentBounds[i] = GetAgent(i).GetBounds();
+		}
+
+		islands.Build(ropeBounds, agentBounds, islandMargin);
+
+		const auto& agentIslands = islands.GetIslands();
+		const auto& freeRopes = islands.GetFreeRopes();
+		std::size_t nChunks = (freeRopes.size() + freeChunkSize - 1) / freeChunkSize;
+
+		if (islandBatches.size() < agentIslands.size()) {
+			islandBatches.resize(agentIslands.size());
+			islandContacts.resize(agentIslands.size());
+		}
+
+		threadPool.ParallelFor(agentIslands.size() + nChunks, [&](std::size_t task) {
+			if (task < agentIslands.size()) {
+				SolveIsland(agentIslands[task], islandBatches[task], islandContacts[task]);
+				return;
+			}
+
+			std::size_t begin = (task - agentIslands.size()) * freeChunkSize;
+			std::size_t end = std::min(begin + freeChunkSize, freeRopes.size());
+			for (std::size_t i = begin; i < end; i++) {
+				strings[freeRopes[i]].Relax();
+			}
+		});
+	}
+
+	//Tests all ropes of the island against the agent in one batch, falling back to
+	//a single-rope test for the ropes after one that has moved the agent.
+	//Islands of several agents test each rope against each of their agents instead.
+	void SolveIsland(const RopeIsland& island, SegmentBatch& batch, std::vector<RopeContact>& contacts) {
+		if (island.agents.size() > 1) {
+			for (uint32_t r : island.ropes) {
+				RopeAgentLogic(strings[r], island.agents.data(), island.agents.size());
 			}
+			return;
+		}
+
+		Player& player = GetAgent(island.agents[0]);
+
+		batch.Clear();
+		for (uint32_t r : island.ropes) {
+			strings[r].AddToBatch(batch);
+		}
+
+		sf::Vector2f testedPosition = player.GetPosition();
+		batch.Test(player.GetFeetBounds(), contacts);
+
+		for (std::size_t i = 0; i < island.ropes.size(); i++) {
+			auto& rope = strings[island.ropes[i]];
+
+			if (player.GetPosition() == testedPosition) {
+				rope.Logic(player, contacts[i]);
+			}
+			else {
+				rope.Logic(player);
+			}
+		}
+	}
+
+	void BuildSnapshot(GameSnapshot& snapshot) {
+		snapshot.sequence = sequence;
+		snapshot.inputTime = input.eventTime;
+		snapshot.playerShape = player.GetShape();
+
+		snapshot.agentQuads.clear();
+		for (auto& agent : agents) {
+			sf::FloatRect bounds = agent.player.GetBounds();
+			sf::Color color(0, 160, 255);
+			snapshot.agentQuads.emplace_back(sf::Vector2f(bounds.left, bounds.top), color);
+			snapshot.agentQuads.emplace_back(sf::Vector2f(bounds.left + bounds.width, bounds.top), color);
+			snapshot.agentQuads.emplace_back(sf::Vector2f(bounds.left + bounds.width, bounds.top + bounds.height), color);
+			snapshot.agentQuads.emplace_back(sf::Vector2f(bounds.left, bounds.top + bounds.height), color);
+		}
+
+		snapshot.stringLines.clear();
+		for (auto& a : strings) {
+			a.AppendLines(snapshot.stringLines);
+		}
+
+		snapshot.lineEditor = lineEditor;
+		snapshot.activeStringIndex = activeStringIndex;
+
+		auto string = strings.Get(selectedString);
+		snapshot.hasSelection = string != nullptr;
+		if (string) snapshot.selectionBounds = string->GetBounds();
+
+		snapshot.navPathLines.clear();
+		if (isNavPathVisible) AppendNavPath(snapshot.navPathLines);
+	}
+
+	//Path from the player to the tile under the mouse, one line per move
+	void AppendNavPath(std::vector<sf::Vertex>& lines) {
+		sf::Vector2f half(pixelSize / 2.0f, pixelSize / 2.0f);
+		int64_t start = navGraph.FindNode(player.GetPosition());
+		int64_t goal = navGraph.FindNode((sf::Vector2f)input.mousePos - half);
+		if (start < 0 || goal < 0) return;
+
+		const std::vector<NavEdge>* path = navGraph.FindPath((uint32_t)start, (uint32_t)goal);
+		if (!path) return;
+
+		const sf::Color colors[] = { sf::Color::White, sf::Color::Green, sf::Color(255, 160, 0), sf::Color::Magenta };
+		sf::Vector2f from = navGraph.GetCellPosition((uint32_t)start) + half;
+		for (auto& edge : *path) {
+			sf::Vector2f to = navGraph.GetCellPosition(edge.target) + half;
+			lines.emplace_back(from, colors[(int)edge.move]);
+			lines.emplace_back(to, colors[(int)edge.move]);
+			from = to;
+		}
+	}
+
+	void Render(const GameSnapshot& snapshot) {
+		bool isOverview = isOverviewVisible;
+		if (isOverview) {
+			window.setView(levelOverview.GetFittingView(window.getSize()));
+			levelOverview.Render(window);
+		}
+		else {
+			tileMesh.Render(window);
 		}
+		if (isOverlayVisible) overlay.Render(window);
 
-		activeString.setFillColor(activeStringIndex == 0 ? sf::Color::White : sf::Color::Magenta);z
+		window.draw(snapshot.playerShape);
+		if (!snapshot.agentQuads.empty()) {
+			window.draw(snapshot.agentQuads.data(), snapshot.agentQuads.size(), sf::Quads);
+		}
+		if (!snapshot.stringLines.empty()) {
+			window.draw(snapshot.stringLines.data(), snapshot.stringLines.size(), sf::Lines);
+		}
+		if (!snapshot.navPathLines.empty()) {
+			window.draw(snapshot.navPathLines.data(), snapshot.navPathLines.size(), sf::Lines);
+		}
+
+		if (snapshot.hasSelection) {
+			const sf::FloatRect& bounds = snapshot.selectionBounds;
+			selectionBox.setPosition({ bounds.left - 4.0f, bounds.top - 4.0f });
+			selectionBox.setSize({ bounds.width + 8.0f, bounds.height + 8.0f });
+			window.draw(selectionBox);
+		}
+
+		//Editor widgets are in window coordinates
+		if (isOverview) window.setView(window.getDefaultView());
+
+		activeString.setFillColor(GetStringColor(snapshot.activeStringIndex));
 		window.draw(activeString);
 
-		lineEditor.Render(window, activeStringIndex);
+		snapshot.lineEditor.Render(window, snapshot.activeStringIndex);
+	}
+
+	//Simulation side: queues this tick's tile changes and hands the snapshot over
+	void PublishSnapshot() {
+		sequence++;
+
+		LevelRegion dirty = level.TakeDirtyRegion();
+		if (!dirty.IsEmpty()) {
+			TilePatch patch;
+			patch.sequence = sequence;
+			patch.levelWidth = level.GetWidth();
+			patch.levelHeight = level.GetHeight();
+			patch.region = dirty;
+			level.CopyRegion(dirty, patch.tiles);
+			pendingPatches.push_back(std::move(patch));
+		}
+
+		//Patches stay queued until the renderer has applied a snapshot that carried them
+		uint64_t acknowledged = acknowledgedSequence.load(std::memory_order_acquire);
+		while (!pendingPatches.empty() && pendingPatches.front().sequence <= acknowledged) {
+			pendingPatches.pop_front();
+		}
+
+		//So does the input time, or a snapshot overwritten before it was shown would drop its sample
+		if (unshownInputTime != LatencyClock::time_point() && unshownInputSequence <= acknowledged) {
+			unshownInputTime = LatencyClock::time_point();
+		}
+		if (unshownInputTime == LatencyClock::time_point()) unshownInputSequence = sequence;
+		LatencyTracker::MergeInputTime(unshownInputTime, input.eventTime);
+
+		GameSnapshot& snapshot = snapshots.GetWriteBuffer();
+		BuildSnapshot(snapshot);
+		snapshot.inputTime = unshownInputTime;
+		snapshot.tilePatches.assign(pendingPatches.begin(), pendingPatches.end());
+		snapshots.Publish();
+	}
 
-		player.Render(window);
+	//Render side
+	void RenderLoop() {
+		window.setActive(true);
+
+		while (isRendering) {
+			watcher.CommitReloads(ReloadRender);
+			ApplyDisplaySettings();
+
+			if (snapshots.Acquire()) {
+				ApplyTilePatches(snapshots.GetReadBuffer());
+			}
+
+			LevelRegion dirty = renderLevel.TakeDirtyRegion();
+			tileMesh.Update(renderLevel, dirty);
+			levelOverview.Update(renderLevel, dirty);
+			overlay.SetBounds({ 0.0f, 0.0f, renderLevel.GetWidth() * pixelSize, renderLevel.GetHeight() * pixelSize });
+
+			FrameArena::Get().Reset();
+			window.clear();
+			Render(snapshots.GetReadBuffer());
+			window.display();
+
+			latency.OnFrameDisplayed(snapshots.GetReadBuffer().inputTime, GetPacingName(true));
+		}
+
+		window.setActive(false);
+	}
+
+	void ApplyTilePatches(const GameSnapshot& snapshot) {
+		for (auto& patch : snapshot.tilePatches) {
+			if (patch.sequence <= appliedSequence) continue;
+
+			if (renderLevel.GetWidth() != patch.levelWidth || renderLevel.GetHeight() != patch.levelHeight) {
+				renderLevel.ClearLevel();
+				renderLevel.InitializeLevelString(patch.levelWidth, patch.levelHeight);
+			}
+			renderLevel.PasteRegion(patch.region, patch.tiles);
+		}
+
+		appliedSequence = snapshot.sequence;
+		acknowledgedSequence.store(appliedSequence, std::memory_order_release);
+	}
+
+	void SimulationLoop() {
+		const auto tickLength = std::chrono::microseconds(1000000 / 60);
+		auto nextTick = std::chrono::steady_clock::now();
+
+		while (isSimulating) {
+			//Events stamped before this tick was due belong to it, later ones wait for the next
+			LatencyClock::time_point eventTime;
+			while (const TimedEvent* timed = eventQueue.Front()) {
+				if (timed->time > nextTick) break;
+
+				if (IsInputEvent(timed->event)) LatencyTracker::MergeInputTime(eventTime, timed->time);
+				devices.Apply(timed->event);
+				ManageEvent(timed->event);
+				eventQueue.Pop();
+			}
+
+			watcher.CommitReloads(ReloadSimulation);
+
+			//The window belongs to the other threads, so the input comes from the events alone
+			input = actions.Capture(devices, input);
+			input.eventTime = eventTime;
+			Tick();
+			PublishSnapshot();
+
+			nextTick += tickLength;
+			std::this_thread::sleep_until(nextTick);
+		}
+	}
+
+	//First rope passing within a few pixels of the point
+	Handle PickString(const sf::Vector2f& pos) const {
+		sf::FloatRect box = { pos.x - 4.0f, pos.y - 4.0f, 8.0f, 8.0f };
+
+		for (std::size_t i = 0; i < strings.size(); i++) {
+			if (strings[i].FindContact(box).isHit) return strings.GetHandle(i);
+		}
+
+		return Handle();
+	}
+
+	void RemoveString(Handle handle) {
+		strings.Remove(handle);
+		if (handle == selectedString) selectedString = Handle();
+		areNavRopesDirty = true;
+	}
+
+	//Hands the tiles changed this tick and, if they changed, the ropes to the navigation graph
+	void SyncNavGraph() {
+		navGraph.Invalidate(level.PeekDirtyRegion());
+		if (!areNavRopesDirty) return;
+
+		std::vector<NavRope> ropes;
+		ropes.reserve(strings.size());
 		for (auto& a : strings) {
-			a->Render(window);
+			const StringRopeMain& main = a.GetMain();
+			NavRope rope;
+			if (GetNavRope(a.GetType(), main.GetPosition(), main.stringLength, rope)) ropes.push_back(rope);
 		}
+
+		navGraph.SetRopes(ropes);
+		areNavRopesDirty = false;
 	}
 
 	void ManageEvent(sf::Event e) {
@@ -391,50 +1330,163 @@ private:
 		case sf::Event::MouseWheelScrolled:
 			switch ((int)e.mouseWheelScroll.delta) {
 			case -1:
-				activeStringIndex = StringRopeMain::StringRope;
+				activeStringIndex = std::max(activeStringIndex - 1, (int)StringRopeMain::StringRope);
 				break;
 			case 1:
-				activeStringIndex = StringRopeMain::StringBounce;
+				activeStringIndex = std::min(activeStringIndex + 1, (int)StringRopeMain::StringTypeCount - 1);
 				break;
 			}
 			break;
 		case sf::Event::KeyPressed:
 			switch (e.key.code) {
-			case sf::Keyboard::Z:
-				if (strings.size() > 0) {
-					strings.pop_back();
-				}
+			case sf::Keyboard::P:
+				isParallelLogic = !isParallelLogic;
 				break;
-			case sf::Keyboard::LShift:
-				isKeyPressed = true;
+			case sf::Keyboard::Num1:
+				paintTile = '#';
 				break;
-			}
-			break;
-		case sf::Event::KeyReleased:
-			switch (e.key.code) {
-			case sf::Keyboard::LShift:
-				isKeyPressed = false;
+			case sf::Keyboard::Num2:
+				paintTile = '=';
+				break;
+			case sf::Keyboard::Num3:
+				paintTile = '^';
+				break;
+			case sf::Keyboard::B:
+				paintTool = PaintTool::Brush;
+				break;
+			case sf::Keyboard::R:
+				paintTool = PaintTool::Rectangle;
+				break;
+			case sf::Keyboard::F:
+				paintTool = PaintTool::Fill;
+				break;
+			case sf::Keyboard::N:
+				isNavPathVisible = !isNavPathVisible;
+				break;
+			case sf::Keyboard::F5:
+				quickSave.clear();
+				SaveState(quickSave);
+				SaveStateFile("quicksave.state", quickSave);
+				break;
+			case sf::Keyboard::F9:
+				if (!quickSave.empty()) LoadState(quickSave);
 				break;
 			}
 			break;
 		}
 
-		lineEditor.ManageEvent(strings, activeStringIndex, e);
+		if (actions.IsEvent(Action::SelectRope, e) && !isOverviewVisible) {
+			sf::Vector2i pos = e.type == sf::Event::MouseButtonPressed ? sf::Vector2i(e.mouseButton.x, e.mouseButton.y) : input.mousePos;
+			selectedString = PickString((sf::Vector2f)pos);
+		}
+
+		if (actions.IsEvent(Action::UndoRope, e)) {
+			//Undo the most recent placement that still exists
+			while (!placementHistory.empty() && !strings.IsValid(placementHistory.back())) {
+				placementHistory.pop_back();
+			}
+			if (!placementHistory.empty()) {
+				RemoveString(placementHistory.back());
+				placementHistory.pop_back();
+			}
+		}
+
+		if (actions.IsEvent(Action::DeleteRope, e)) {
+			RemoveString(selectedString);
+		}
+
+		Handle placed = isOverviewVisible ? Handle() : lineEditor.ManageEvent(strings, activeStringIndex, actions, e, input.mousePos);
+		if (strings.IsValid(placed)) {
+			placementHistory.push_back(placed);
+			areNavRopesDirty = true;
+		}
+	}
+
+	//Display settings, applied by the thread that draws
+	void ManageDisplayEvent(const sf::Event& e) {
+		if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::V) {
+			isVerticalSync = !isVerticalSync;
+		}
+
+		if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::G) {
+			isOverlayVisible = !isOverlayVisible;
+		}
+
+		if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::O) {
+			isOverviewVisible = !isOverviewVisible;
+		}
+
+		if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F1) {
+			AssetHolder::Get().PrintStats(std::cout);
+			FrameArena::Get().PrintStats(std::cout);
+		}
+	}
+
+	void ApplyDisplaySettings() {
+		bool isEnabled = isVerticalSync;
+		if (isEnabled == isVerticalSyncApplied) return;
+
+		window.setVerticalSyncEnabled(isEnabled);
+		window.setFramerateLimit(isEnabled ? 0 : 60);
+		isVerticalSyncApplied = isEnabled;
+	}
+
+	const char* GetPacingName(bool isPipelined) const {
+		if (isVerticalSync) return isPipelined ? "pipelined, vsync" : "serial, vsync";
+		return isPipelined ? "pipelined, 60 fps limit" : "serial, 60 fps limit";
 	}
 public:
-	Game(uint32_t x, uint32_t y, const sf::String& title)
+	//threadCount counts the calling thread, so 1 runs the rope islands serially.
+	//A headless game never opens its window, for --bench and --check.
+	Game(uint32_t x, uint32_t y, const sf::String& title, uint32_t threadCount = ThreadPool::DefaultThreadCount() + 1, bool isHeadless = false)
 		: windowSize(x, y),
-		  window({ x, y }, title) {
+		  threadPool(threadCount > 1 ? threadCount - 1 : 0),
+		  navGraph(level, &threadPool) {
+		if (!isHeadless) window.create({ x, y }, title);
 		window.setFramerateLimit(60);
 
 		pixelSize = 32.0f;
+		paintTile = '#';
+		paintTool = PaintTool::Brush;
+		tileMesh.SetTileSize(pixelSize);
+		overlay.SetCellSize(pixelSize);
+		isOverlayVisible = false;
+		levelOverview.SetTileSize(pixelSize);
+		isOverviewVisible = false;
+
 		player.SetPosition({ 32.0f, 32.0f });
+		player.SetSpawnPosition({ 32.0f, 32.0f });
+
+		navGraph.SetParams(GetAgentNavParams());
+		areNavRopesDirty = true;
+		isNavPathVisible = false;
+
+		activeStringIndex = StringRopeMain::StringRope;
+
+		acknowledgedSequence = 0;
+		isSimulating = false;
+		sequence = appliedSequence = 0;
+		unshownInputSequence = 0;
+		islandMargin = GetIslandMargin();
+		isParallelLogic = true;
+		isVerticalSync = false;
+		isVerticalSyncApplied = false;
+		isRendering = false;
+		wasPlayerGrounded = false;
+		ticksSinceRecord = 0;
+		for (int type = 0; type < StringRopeMain::StringTypeCount; type++) {
+			scratchStrings.push_back(StringRopeVariant::Create(type));
+		}
 
-		isKeyPressed = false;
+		LoadSounds();
+		AssetHolder::Get().WatchAssets(watcher, ReloadRender, ReloadSimulation);
 
-		pixel.setSize({ pixelSize, pixelSize });
 		activeString.setSize({ pixelSize, pixelSize });
 
+		selectionBox.setFillColor(sf::Color::Transparent);
+		selectionBox.setOutlineColor(sf::Color::Green);
+		selectionBox.setOutlineThickness(1.0f);
+
 		level.SetLevel({
 			"################",
 			"#..............#",
@@ -455,31 +1507,438 @@ public:
 		});
 	}
 
+	//One simulation tick, or one step back through the recorded states while rewind is held
+	void Tick() {
+		const uint32_t ticksPerRecord = 4;
+
+		if (input.IsDown(Action::Rewind)) {
+			const std::vector<uint8_t>* state = rewindStates.Pop();
+			if (state) LoadState(*state);
+			ticksSinceRecord = 0;
+			SyncNavGraph();
+			return;
+		}
+
+		Input(input);
+		Logic();
+
+		if (++ticksSinceRecord >= ticksPerRecord) {
+			SaveState(rewindStates.Push());
+			ticksSinceRecord = 0;
+		}
+
+		SyncNavGraph();
+	}
+
+	//Times the simulation alone, without input, rewind recording or drawing. Each run prints
+	//one line, so running it with each --threads from 1 up gives the scaling curve.
+	void Benchmark(uint32_t ticks, std::ostream& out) {
+		std::vector<double> times;
+		times.reserve(ticks);
+
+		for (uint32_t i = 0; i < ticks; i++) {
+			auto start = std::chrono::steady_clock::now();
+			Logic();
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		if (times.empty()) return;
+
+		std::sort(times.begin(), times.end());
+		double total = 0.0;
+		for (double time : times) total += time;
+
+		std::size_t verletRopes = 0, verletSegments = 0;
+		for (auto& a : strings) {
+			std::size_t particles = a.GetParticleCount();
+			verletRopes += particles > 0;
+			verletSegments += particles > 0 ? particles - 1 : 0;
+		}
+
+		out << "Threads: " << threadPool.GetThreadCount() << ", ropes: " << strings.size()
+			<< " (" << verletRopes << " Verlet, " << verletSegments << " segments), agents: " << GetAgentCount()
+			<< ", mean tick: " << total / times.size() << " ms, median: " << times[times.size() / 2]
+			<< " ms, slowest: " << times.back() << " ms" << std::endl;
+
+		//Rewinding loads a state every tick it is held, so a load has to stay well under a millisecond
+		const uint32_t rounds = 100;
+		std::vector<uint8_t> state;
+		double saveTime = 0.0, loadTime = 0.0;
+		for (uint32_t i = 0; i < rounds; i++) {
+			auto start = std::chrono::steady_clock::now();
+			state.clear();
+			SaveState(state);
+			auto saved = std::chrono::steady_clock::now();
+			LoadState(state);
+			auto loaded = std::chrono::steady_clock::now();
+
+			saveTime += std::chrono::duration<double, std::milli>(saved - start).count();
+			loadTime += std::chrono::duration<double, std::milli>(loaded - saved).count();
+		}
+
+		out << "State: " << state.size() / 1024 << " KiB, mean save: " << saveTime / rounds
+			<< " ms, mean load: " << loadTime / rounds << " ms" << std::endl;
+	}
+
+	//Runs the same ticks once with the ropes in order and once in islands on the pool, from the
+	//same state. Both have to end in the same state byte for byte.
+	bool CheckParallelLogic(uint32_t ticks, std::ostream& out) {
+		std::vector<uint8_t> start, results[2];
+		SaveState(start);
+		bool wasParallelLogic = isParallelLogic;
+
+		for (int mode = 0; mode < 2; mode++) {
+			LoadState(start);
+			isParallelLogic = mode == 1;
+			for (uint32_t i = 0; i < ticks; i++) {
+				Logic();
+			}
+			SaveState(results[mode]);
+		}
+
+		isParallelLogic = wasParallelLogic;
+		LoadState(start);
+
+		bool isSame = results[0] == results[1];
+		out << "Parallel rope logic: " << ticks << " ticks with " << strings.size() << " ropes and " << GetAgentCount()
+			<< " agents on " << threadPool.GetThreadCount() << " threads, " << (isSame ? "same as" : "differs from")
+			<< " the serial run" << std::endl;
+		return isSame;
+	}
+
+	//Loads the state cut short at evenly spaced lengths after the world has moved on from it.
+	//Every load has to fail and leave the world byte for byte as it was.
+	bool CheckStateLoad(uint32_t cuts, std::ostream& out) {
+		std::vector<uint8_t> state, world, after;
+		SaveState(state);
+		for (uint32_t i = 0; i < 60; i++) {
+			Logic();
+		}
+		SaveState(world);
+
+		uint32_t mismatches = 0;
+		for (uint32_t k = 0; k < cuts; k++) {
+			std::vector<uint8_t> cut(state.begin(), state.begin() + state.size() * k / cuts);
+			bool isLoaded = LoadState(cut);
+
+			after.clear();
+			SaveState(after);
+			mismatches += isLoaded || after != world;
+		}
+
+		out << "State load: " << cuts << " truncated states of " << state.size() << " bytes, " << mismatches
+			<< " loaded or changed the world" << std::endl;
+		return mismatches == 0;
+	}
+
+	//Appends the whole world: level, player, ropes in pool order and agents
+	void SaveState(std::vector<uint8_t>& bytes) const {
+		StateWriter out(bytes);
+		out.WriteHeader();
+
+		level.SaveState(out);
+		player.SaveState(out);
+		out.Write(wasPlayerGrounded);
+
+		out.Write((uint32_t)strings.size());
+		for (auto& a : strings) {
+			a.SaveState(out);
+		}
+
+		out.Write((uint32_t)agents.size());
+		for (auto& agent : agents) {
+			agent.player.SaveState(out);
+			out.WriteArray(agent.script);
+			out.Write(agent.step);
+			out.Write(agent.tick);
+		}
+	}
+
+	//Reads the whole state, into the world or with isDryRun into the scratch objects only.
+	//Whether a read succeeds depends on nothing but the bytes, so a state that passes the
+	//dry run is sure to load.
+	bool ReadState(const std::vector<uint8_t>& bytes, bool isDryRun) {
+		StateReader in(bytes);
+		if (in.ReadHeader() != stateVersion) return false;
+
+		bool isGrounded = false;
+		bool isRead = (isDryRun ? scratchLevel : level).LoadState(in) &&
+			(isDryRun ? scratchAgent.player : player).LoadState(in) && in.Read(isGrounded);
+		if (!isDryRun) wasPlayerGrounded = isGrounded;
+
+		uint32_t nStrings = 0;
+		isRead = isRead && in.Read(nStrings);
+		for (uint32_t i = 0; isRead && i < nStrings; i++) {
+			if (isDryRun) {
+				uint8_t type = 0;
+				isRead = in.Peek(type) && type < scratchStrings.size() && scratchStrings[type].LoadState(in);
+				continue;
+			}
+
+			if (i == strings.size()) strings.Insert(StringRopeVariant::Create(StringRopeMain::StringRope));
+			isRead = strings[i].LoadState(in);
+		}
+		if (!isDryRun) {
+			while (strings.size() > nStrings) {
+				strings.Remove(strings.GetHandle(strings.size() - 1));
+			}
+			areNavRopesDirty = true;
+			if (!strings.IsValid(selectedString)) selectedString = Handle();
+		}
+
+		uint32_t nAgents = 0;
+		isRead = isRead && in.Read(nAgents) && nAgents <= in.GetRemaining();
+		if (isRead && !isDryRun) agents.resize(nAgents);
+		for (uint32_t k = 0; isRead && k < nAgents; k++) {
+			Agent& agent = isDryRun ? scratchAgent : agents[k];
+			isRead = agent.player.LoadState(in) && in.ReadArray(agent.script) && in.Read(agent.step) && in.Read(agent.tick);
+			isRead = isRead && agent.step < agent.script.size();
+		}
+
+		return isRead;
+	}
+
+	//Ropes are loaded into the existing ones where possible, so restoring the state a
+	//rewind recorded a moment ago neither allocates nor invalidates handles. A state that
+	//can't be read leaves the world as it was.
+	bool LoadState(const std::vector<uint8_t>& bytes) {
+		StateReader in(bytes);
+		if (in.ReadHeader() != stateVersion) {
+			std::cout << "Unsupported save state" << std::endl;
+			return false;
+		}
+
+		if (!ReadState(bytes, true)) {
+			std::cout << "Corrupt save state, nothing was loaded" << std::endl;
+			return false;
+		}
+
+		return ReadState(bytes, false);
+	}
+
+	//Starts from a state saved with F5, e.g. to benchmark from the middle of a session
+	bool LoadSavedState(const std::string& filepath) {
+		std::vector<uint8_t> bytes;
+		if (!LoadStateFile(filepath, bytes)) {
+			std::cout << "Couldn't load the save state " << filepath << std::endl;
+			return false;
+		}
+
+		return LoadState(bytes);
+	}
+
+	//Replaces the level, ropes and agents with a generated scene
+	void LoadScene(const StressScene& scene) {
+		level.SetLevel(scene.rows);
+
+		strings.Clear();
+		placementHistory.clear();
+		selectedString = Handle();
+		for (auto& spawn : scene.ropes) {
+			Handle handle = strings.Insert(StringRopeVariant::Create(spawn.type));
+			strings.Get(handle)->Place(spawn.position, spawn.length);
+		}
+		areNavRopesDirty = true;
+
+		player.SetPosition(scene.playerSpawn);
+		player.SetSpawnPosition(scene.playerSpawn);
+
+		agents.clear();
+		for (auto& spawn : scene.agents) {
+			if (spawn.script.empty()) continue;
+
+			Agent agent;
+			agent.player.SetPosition(spawn.position);
+			agent.player.SetSpawnPosition(spawn.position);
+			agent.script = spawn.script;
+			agent.step = agent.tick = 0;
+			agents.push_back(std::move(agent));
+		}
+	}
+
+	//Plays the level from a file and re-applies the rows that change whenever the file is saved
+	bool LoadLevelFile(const std::string& filepath) {
+		std::vector<std::string> rows;
+		if (!Level::ReadLevelRows(filepath, rows)) {
+			std::cout << "Couldn't load the level " << filepath << std::endl;
+			return false;
+		}
+		level.SetLevel(rows);
+
+		watcher.Watch(filepath, [this](const std::string& path) -> FileWatcher::Commit {
+			auto staged = std::make_shared<std::vector<std::string>>();
+			if (!Level::ReadLevelRows(path, *staged)) return nullptr;
+			return [this, staged]() { level.UpdateLevel(*staged); };
+		}, ReloadSimulation);
+
+		return true;
+	}
+
 	void GameLogic() {
 		while (window.isOpen()) {
 			sf::Event e;
 			while (window.pollEvent(e)) {
+				if (IsInputEvent(e)) LatencyTracker::MergeInputTime(pendingInputTime, LatencyClock::now());
+				ManageDisplayEvent(e);
 				ManageEvent(e);
 			}
 		
-			Input();
-			Logic();
-
+			watcher.CommitReloads(ReloadSimulation);
+			watcher.CommitReloads(ReloadRender);
+			ApplyDisplaySettings();
+
+			input = actions.Capture(window, input);
+			input.eventTime = pendingInputTime;
+			pendingInputTime = LatencyClock::time_point();
+			Tick();
+			BuildSnapshot(frameSnapshot);
+
+			LevelRegion dirty = level.TakeDirtyRegion();
+			tileMesh.Update(level, dirty);
+			levelOverview.Update(level, dirty);
+			overlay.SetBounds({ 0.0f, 0.0f, level.GetWidth() * pixelSize, level.GetHeight() * pixelSize });
+
+			FrameArena::Get().Reset();
 			window.clear();
-			Render();
+			Render(frameSnapshot);
 			window.display();
+
+			latency.OnFrameDisplayed(frameSnapshot.inputTime, GetPacingName(false));
 		}
 	}
 
-	void Run() {
-		GameLogic();
+	//Pipelined mode: this thread only ingests events, blocking until one arrives and stamping
+	//it right away. The simulation runs on its own thread at a fixed 60 Hz and drawing the
+	//latest snapshot on a third, which owns the window's context.
+	void GameLogicPipelined() {
+		renderLevel = level;
+		level.TakeDirtyRegion();
+
+		isSimulating = true;
+		isRendering = true;
+		window.setActive(false);
+		std::thread simulation(&Game::SimulationLoop, this);
+		std::thread rendering(&Game::RenderLoop, this);
+
+		sf::Event e;
+		while (window.waitEvent(e)) {
+			LatencyClock::time_point time = LatencyClock::now();
+
+			if (e.type == sf::Event::Closed) break;
+			ManageDisplayEvent(e);
+
+			while (!eventQueue.TryPush({ e, time })) {
+				std::this_thread::yield();
+			}
+		}
+
+		isRendering = false;
+		isSimulating = false;
+		rendering.join();
+		simulation.join();
+
+		window.setActive(true);
+		window.close();
+	}
+
+	void Run(bool isPipelined = false) {
+		if (isPipelined) GameLogicPipelined();
+		else GameLogic();
 	}
 };
 
-int main() {
+//Reads a whole command line value as a number no smaller than minimum, or reports it
+template<typename T>
+bool ParseArgument(const std::string& arg, const char* text, T& value, T minimum = 0) {
+	const char* end = text + std::strlen(text);
+	T parsed = 0;
+	auto [last, error] = std::from_chars(text, end, parsed);
+	if (error != std::errc() || last != end || parsed < minimum) {
+		std::cout << "Invalid value for " << arg << ": " << text << std::endl;
+		return false;
+	}
 
-	Game game(512, 512, "Title");
-	game.Run();
+	value = parsed;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	bool isPipelined = false, isScene = false, isCheck = false, isValid = true;
+	uint32_t threadCount = ThreadPool::DefaultThreadCount() + 1, benchTicks = 0;
+	std::string levelFile, stateFile, musicFile;
+	StressSceneParams sceneParams;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--pipelined") isPipelined = true;
+		if (arg == "--level" && hasValue) levelFile = argv[++i];
+		if (arg == "--state" && hasValue) stateFile = argv[++i];
+		if (arg == "--music" && hasValue) musicFile = argv[++i];
+
+		//--scene <seed> [--size <tiles>] [--ropes <count>] [--verlet <count>] [--agents <count>]
+		if (arg == "--scene" && hasValue) {
+			isScene = true;
+			isValid = ParseArgument(arg, argv[++i], sceneParams.seed) && isValid;
+		}
+		if (arg == "--size" && hasValue) {
+			//The generator needs room for the walls, a platform and the starting corner
+			isValid = ParseArgument(arg, argv[++i], sceneParams.width, 8u) && isValid;
+			sceneParams.height = sceneParams.width;
+		}
+		if (arg == "--ropes" && hasValue) isValid = ParseArgument(arg, argv[++i], sceneParams.ropeCount) && isValid;
+		if (arg == "--verlet" && hasValue) isValid = ParseArgument(arg, argv[++i], sceneParams.verletCount) && isValid;
+		if (arg == "--agents" && hasValue) isValid = ParseArgument(arg, argv[++i], sceneParams.agentCount) && isValid;
+
+		//--bench <ticks> [--threads <count>] times that many ticks and exits
+		if (arg == "--threads" && hasValue) isValid = ParseArgument(arg, argv[++i], threadCount, 1u) && isValid;
+		if (arg == "--bench" && hasValue) isValid = ParseArgument(arg, argv[++i], benchTicks) && isValid;
+
+		//--check [--scene <seed>] [--size <tiles>] runs the self checks without opening a window
+		if (arg == "--check") isCheck = true;
+	}
+	if (!isValid) return 1;
+
+	if (isCheck) {
+		StressScene scene = SceneGenerator::Generate(sceneParams);
+		Level level;
+		level.SetLevel(scene.rows);
+		ThreadPool pool(threadCount - 1);
+
+		std::vector<NavRope> ropes;
+		for (auto& spawn : scene.ropes) {
+			NavRope rope;
+			if (GetNavRope(spawn.type, spawn.position, spawn.length, rope)) ropes.push_back(rope);
+		}
+
+		bool isPassed = SelfCheck::CheckRaycasts(level, sceneParams.tileSize, pool, 100000, sceneParams.seed, std::cout);
+		isPassed = SelfCheck::CheckNavGraph(level, GetAgentNavParams(), ropes, pool, 64, sceneParams.seed, std::cout) && isPassed;
+
+		//Agents and Verlet ropes are what the rope islands are about, so the scene gets some of both
+		StressSceneParams busyParams = sceneParams;
+		busyParams.agentCount = std::max(busyParams.agentCount, 64u);
+		busyParams.verletCount = std::max(busyParams.verletCount, busyParams.ropeCount / 4);
+
+		Game game(512, 512, "Title", threadCount, true);
+		game.LoadScene(SceneGenerator::Generate(busyParams));
+		isPassed = game.CheckParallelLogic(600, std::cout) && isPassed;
+		isPassed = game.CheckStateLoad(16, std::cout) && isPassed;
+		return isPassed ? 0 : 1;
+	}
+
+	Game game(512, 512, "Title", threadCount, benchTicks > 0);
+	if (isScene) game.LoadScene(SceneGenerator::Generate(sceneParams));
+	if (!levelFile.empty()) game.LoadLevelFile(levelFile);
+	if (!stateFile.empty()) game.LoadSavedState(stateFile);
+	if (benchTicks > 0) {
+		game.Benchmark(benchTicks, std::cout);
+		return 0;
+	}
+
+	//Streamed rather than loaded, so a long track costs a small buffer instead of the whole file
+	if (!musicFile.empty() && !AudioManager::Get().PlayMusic(musicFile)) {
+		std::cout << "Couldn't play the music " << musicFile << std::endl;
+	}
+	game.Run(isPipelined);
 
 	return 0;
 }
\ No newline at end of file